@@ -9,15 +9,36 @@ namespace zhoni04 {
  * @class FenwickTree
  * @brief Implements a Fenwick Tree based on array, this class supports
  * operations of two types: (a) increment an element in the array or (b) query
- * the prefix sum of a portion of the array.
+ * the prefix sum of a portion of the array. It can also be built from an
+ * existing array in linear time and find the position where a prefix sum is
+ * first reached.
+ * @tparam T: The value type.
  */
+template <typename T = long long>
 class FenwickTree {
  public:
   /**
-   * @brief Initializes a new instance of Fenwick Tree.
+   * @brief Initializes a new instance of Fenwick Tree with all zeros.
    * @param n: The length of the array, assumed to be positive.
    */
-  explicit FenwickTree(int n) : n_(n + 1), arr_(n_, 0) {}
+  explicit FenwickTree(int n) : n_(n), arr_(n_ + 1, 0) {}
+
+  /**
+   * @brief Initializes a new instance of Fenwick Tree from the given array.
+   * Each node pushes its partial sum to its parent once, so the time
+   * complexity is O(n) instead of O(nlog(n)) for n calls of Add.
+   * @param values: The initial array.
+   */
+  explicit FenwickTree(const std::vector<T>& values)
+      : n_(values.size()), arr_(n_ + 1, 0) {
+    for (int i = 1; i <= n_; ++i) {
+      arr_[i] += values[i - 1];
+      int parent = i + (i & -i);
+      if (parent <= n_) {
+        arr_[parent] += arr_[i];
+      }
+    }
+  }
 
   /**
    * @brief Increases array value at index with delta. Time complexity:
@@ -25,7 +46,7 @@ class FenwickTree {
    * @param index: The index, assumed to be between 0 ~ n-1 (both inclusive).
    * @param delta: The delta.
    */
-  void Add(int index, int delta) {
+  void Add(int index, T delta) {
     int i = index + 1;
 
     while (i <= n_) {
@@ -40,8 +61,8 @@ class FenwickTree {
    * @param index: The index, assumed to be between 0 ~ n (both inclusive).
    * @return The sum.
    */
-  long long Sum(int index) const {
-    long long sum = 0;
+  T Sum(int index) const {
+    T sum = 0;
 
     while (index > 0) {
       sum += arr_[index];
@@ -51,29 +72,60 @@ class FenwickTree {
     return sum;
   }
 
+  /**
+   * @brief Finds the smallest index such that the sum of array value from
+   * index 0 to index (inclusive) is not less than prefix, assumed all values
+   * are non-negative. With 0/1 values, LowerBound(k) is the index of the k-th
+   * one. Time complexity: O(log(n)).
+   * @param prefix: The prefix sum to reach.
+   * @return The index, or n if the total sum is less than prefix.
+   */
+  int LowerBound(T prefix) const {
+    if (prefix <= 0) {
+      return 0;
+    }
+
+    int pos = 0;
+    int step = 1;
+    while (step * 2 <= n_) {
+      step *= 2;
+    }
+
+    // Descend the implicit tree: arr_[pos + step] is the sum of the next step
+    // values after pos.
+    for (; step > 0; step /= 2) {
+      if (pos + step <= n_ && arr_[pos + step] < prefix) {
+        pos += step;
+        prefix -= arr_[pos];
+      }
+    }
+
+    return pos;
+  }
+
  private:
   int n_;
-  std::vector<long long> arr_;
+  std::vector<T> arr_;
 };
 
 }  // namespace zhoni04
 }  // namespace aaps
 
-using FenwickTree = aaps::zhoni04::FenwickTree;
+using FenwickTree = aaps::zhoni04::FenwickTree<long long>;
 
 int main(void) {
   int N;
   scanf("%d", &N);
-  FenwickTree tree(N);
   std::vector<int> positions(N + 1, 0);
 
   int num;
   for (int i = 1; i <= N; ++i) {
     scanf("%d", &num);
     positions[num] = i;
-    tree.Add(i - 1, 1);
   }
 
+  FenwickTree tree(std::vector<long long>(N, 1));
+
   int curr_not_chosen_min = 1;
   int curr_not_chosen_max = N;
   int pos;
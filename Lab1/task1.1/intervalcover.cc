@@ -7,92 +7,160 @@ namespace zhoni04 {
 
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
- * @brief Implements a function to compare the order of two intervals.
- * @param a: The interval a.
- * @param b: The interval b.
- * @return True if a is before b, otherwise false.
+ * @class CoverIndex
+ * @brief Implements an index over a set of intervals which answers many
+ * interval cover queries. The intervals are sorted by start once and kept as
+ * separate arrays. best_[k] is the interval reaching furthest among the first
+ * k + 1 by start, so the greedy choice from a point is one binary search.
+ * Following the greedy choice from each interval's end gives a jump table,
+ * doubled log(n) times, so a query skips 2^l greedy steps at a time.
  */
-bool CompareFunc(std::vector<double> a, std::vector<double> b) {
-  if (a[0] < b[0]) {
-    return true;
-  } else if (a[0] == b[0]) {
-    return a[1] < b[1];
+class CoverIndex {
+ public:
+  /**
+   * @brief Builds the index. Time complexity: O(nlog(n)).
+   * @param intervals: The set of intervals, two dimensional vector, shape:
+   * n * 2.
+   */
+  explicit CoverIndex(const std::vector<std::vector<double>>& intervals)
+      : n_(intervals.size()), levels_(1) {
+    std::vector<int> order(n_);
+    for (int i = 0; i < n_; ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+      if (intervals[a][0] != intervals[b][0]) {
+        return intervals[a][0] < intervals[b][0];
+      }
+      if (intervals[a][1] != intervals[b][1]) {
+        return intervals[a][1] < intervals[b][1];
+      }
+      return a < b;
+    });
+
+    starts_.resize(n_);
+    ends_.resize(n_);
+    original_.resize(n_);
+    best_.resize(n_);
+    for (int k = 0; k < n_; ++k) {
+      starts_[k] = intervals[order[k]][0];
+      ends_[k] = intervals[order[k]][1];
+      original_[k] = order[k];
+      // On a tie the later interval wins, as the linear scan did.
+      best_[k] = (k == 0 || ends_[k] >= ends_[best_[k - 1]]) ? k : best_[k - 1];
+    }
+
+    while ((1 << levels_) < n_) {
+      ++levels_;
+    }
+
+    // jump_[l * n + k] is the interval reached after 2^l greedy steps from
+    // interval k, or k itself once no interval reaches further.
+    jump_.resize(levels_ * n_);
+    for (int k = 0; k < n_; ++k) {
+      int next = Reach(ends_[k]);
+      jump_[k] = ends_[next] > ends_[k] ? next : k;
+    }
+    for (int l = 1; l < levels_; ++l) {
+      for (int k = 0; k < n_; ++k) {
+        jump_[l * n_ + k] = jump_[(l - 1) * n_ + jump_[(l - 1) * n_ + k]];
+      }
+    }
   }
 
-  return false;
-}
+  /**
+   * @brief Computes the smallest number of intervals required to cover the
+   * target interval. Time complexity: O(log(n)).
+   * @param begin: The start of the target interval.
+   * @param end: The end of the target interval.
+   * @return The number of intervals, -1 if the target can not be covered.
+   */
+  int Count(double begin, double end) const {
+    int curr = Reach(begin);
+    if (curr == -1 || ends_[curr] < begin) {
+      return -1;
+    }
 
-/**
- * @author Zhongjun Ni (LiU-ID: zhoni04)
- * @brief Implements a function to find next alternative interval which can
- * cover the give value and has the largest right value.
- * @param start: The given value.
- * @param index: The start index to find.
- * @param intervals: The intervals.
- * @return -1 if not find, otherwise the index of interval.
- */
-int FindNextInterval(double start, int index,
-                     const std::vector<std::vector<double>>& intervals) {
-  int res = -1;
-  double max_end = start;
-  int len = intervals.size();
-  for (int i = index; i < len; ++i) {
-    if (intervals[i][0] > start) {
-      break;
+    if (ends_[curr] >= end) {
+      return 1;
+    }
+
+    // Take every jump which still ends before the target, then one more step.
+    int count = 1;
+    for (int l = levels_ - 1; l >= 0; --l) {
+      int next = jump_[l * n_ + curr];
+      if (ends_[next] < end) {
+        curr = next;
+        count += 1 << l;
+      }
+    }
+
+    curr = jump_[curr];
+    if (ends_[curr] < end) {
+      return -1;
+    }
+
+    return count + 1;
+  }
+
+  /**
+   * @brief Finds a smallest set of intervals covering the target interval.
+   * Time complexity: O(log(n) + k), k is the number of intervals.
+   * @param begin: The start of the target interval.
+   * @param end: The end of the target interval.
+   * @return The indexes of the intervals in the order they are used, empty
+   * if the target can not be covered.
+   */
+  std::vector<int> Query(double begin, double end) const {
+    int count = Count(begin, end);
+    std::vector<int> result;
+    if (count == -1) {
+      return result;
     }
 
-    if (intervals[i][1] >= max_end) {
-      max_end = intervals[i][1];
-      res = i;
+    result.reserve(count);
+    int curr = Reach(begin);
+    for (int i = 0; i < count; ++i) {
+      result.push_back(original_[curr]);
+      curr = jump_[curr];
     }
+
+    return result;
   }
 
-  return res;
-}
+ private:
+  // Returns the interval reaching furthest among those starting at or
+  // before x, -1 if there is none.
+  int Reach(double x) const {
+    int k = std::upper_bound(starts_.begin(), starts_.end(), x) -
+            starts_.begin();
+    return k == 0 ? -1 : best_[k - 1];
+  }
+
+  int n_;
+  int levels_;
+  std::vector<double> starts_;
+  std::vector<double> ends_;
+  std::vector<int> original_;
+  std::vector<int> best_;
+  std::vector<int> jump_;
+};
 
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implements a function that given a set of intervals and a target
  * interval returns the smallest number of intervals required to cover the
- * target interval. Time complexity: O(nlog(n)).
+ * target interval. For many targets over the same intervals, build a
+ * CoverIndex once instead. Time complexity: O(nlog(n)).
  * @param interval: The target interval, length equals to two.
  * @param intervals: The set of intervals, two dimensional vector, shape: n * 2.
- * @return The possible indexes of intervals.
+ * @return The possible indexes of intervals, empty if the target can not be
+ * covered.
  */
 std::vector<int> Cover(const std::vector<double>& interval,
                        const std::vector<std::vector<double>>& intervals) {
-  std::vector<std::vector<double>> local_intervals(intervals);
-
-  // Add an element to record original index.
-  for (int i = 0; i < local_intervals.size(); ++i) {
-    local_intervals[i].push_back(i);
-  }
-
-  // Sort operation, time complexity: O(nlog(n)).
-  std::sort(local_intervals.begin(), local_intervals.end(), CompareFunc);
-
-  double start = interval[0];
-  double end = interval[1];
-  std::vector<int> result;
-  int index = 0;
-
-  do {
-    int next = FindNextInterval(start, index, local_intervals);
-    if (next != -1) {
-      result.push_back(next);
-      start = local_intervals[next][1];
-      index = next + 1;
-    } else {
-      break;
-    }
-  } while (start < end);
-
-  // Convert to original index;
-  for (int i = 0; i < result.size(); ++i) {
-    result[i] = (int)local_intervals[result[i]][2];
-  }
-
-  return result;
+  CoverIndex index(intervals);
+  return index.Query(interval[0], interval[1]);
 }
 
 }  // namespace zhoni04
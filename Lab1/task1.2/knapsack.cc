@@ -1,53 +1,656 @@
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define AAPS_KNAPSACK_X86 1
+#endif
+
 namespace aaps {
 namespace zhoni04 {
 
+// Adds one item to capacities begin ~ end-1 of a DP row, from high to low:
+// next_row[c] = max(row[c], value + row[c - weight]), with begin >= weight.
+// Every value is loaded before anything at or below it is stored, so
+// next_row may be row. If take is not null, bit c is set when taking the
+// item is strictly better; if origin is not null, next_origin[c] copies
+// origin[c - weight] where the item is taken and origin[c] elsewhere.
+using AddItemFunc = void (*)(int value, int weight, int begin, int end,
+                             const int* row, int* next_row, uint64_t* take,
+                             const int* origin, int* next_origin);
+
+inline void AddItemScalar(int value, int weight, int begin, int end,
+                          const int* row, int* next_row, uint64_t* take,
+                          const int* origin, int* next_origin) {
+  for (int c = end - 1; c >= begin; --c) {
+    int without_item = row[c];
+    int with_item = value + row[c - weight];
+    bool taken = with_item > without_item;
+    next_row[c] = taken ? with_item : without_item;
+    if (take != nullptr) {
+      take[c >> 6] |= (uint64_t)taken << (c & 63);
+    }
+    if (origin != nullptr) {
+      next_origin[c] = taken ? origin[c - weight] : origin[c];
+    }
+  }
+}
+
+#ifdef AAPS_KNAPSACK_X86
+// Eight capacities at a time over blocks starting at multiples of 8, so the
+// take bits of a block are one byte of the bit row.
+__attribute__((target("avx2"))) inline void AddItemAvx2(
+    int value, int weight, int begin, int end, const int* row, int* next_row,
+    uint64_t* take, const int* origin, int* next_origin) {
+  int top = end;
+  while (top > begin && (top & 7) != 0) {
+    --top;
+    AddItemScalar(value, weight, top, top + 1, row, next_row, take, origin,
+                  next_origin);
+  }
+
+  const __m256i values = _mm256_set1_epi32(value);
+  uint8_t* take_bytes = reinterpret_cast<uint8_t*>(take);
+  int block = top - 8;
+  for (; block >= begin; block -= 8) {
+    __m256i without_item = _mm256_loadu_si256((const __m256i*)(row + block));
+    __m256i with_item = _mm256_add_epi32(
+        _mm256_loadu_si256((const __m256i*)(row + block - weight)), values);
+    __m256i taken = _mm256_cmpgt_epi32(with_item, without_item);
+    if (origin != nullptr) {
+      __m256i moved = _mm256_blendv_epi8(
+          _mm256_loadu_si256((const __m256i*)(origin + block)),
+          _mm256_loadu_si256((const __m256i*)(origin + block - weight)),
+          taken);
+      _mm256_storeu_si256((__m256i*)(next_origin + block), moved);
+    }
+    _mm256_storeu_si256((__m256i*)(next_row + block),
+                        _mm256_max_epi32(without_item, with_item));
+    if (take != nullptr) {
+      take_bytes[block >> 3] |=
+          _mm256_movemask_ps(_mm256_castsi256_ps(taken));
+    }
+  }
+
+  AddItemScalar(value, weight, begin, std::min(block + 8, end), row,
+                next_row, take, origin, next_origin);
+}
+#endif
+
+inline AddItemFunc SelectAddItem() {
+#ifdef AAPS_KNAPSACK_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return AddItemAvx2;
+  }
+#endif
+  return AddItemScalar;
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Adds item i to a knapsack DP row in place, so row[c] becomes the
+ * best value of items 0 ~ i with capacity c. Capacities run downwards, so
+ * row[c - weight] still holds the value without item i. The update is branch
+ * free and runs on AVX2 when the CPU has it. Time complexity: O(capacity)
+ * @param value: The value of the item.
+ * @param weight: The weight of the item.
+ * @param capacity: The largest capacity in the row.
+ * @param row: The DP row, of size capacity + 1.
+ * @param take: If not null, bit c of this row of bits is set when taking the
+ * item is strictly better at capacity c.
+ * @param origin: If not null, moved along with the values: origin[c] follows
+ * the taken item to origin[c - weight].
+ */
+inline void AddItem(int value, int weight, int capacity, int* row,
+                    uint64_t* take, int* origin) {
+  static const AddItemFunc kernel = SelectAddItem();
+  // Capacity 0 is never filled, as in the full table.
+  int begin = std::max(weight, 1);
+  if (begin <= capacity) {
+    kernel(value, weight, begin, capacity + 1, row, row, take, origin, origin);
+  }
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class Barrier
+ * @brief Implements a reusable barrier: Wait returns once all threads have
+ * called it, then the barrier is ready for the next round.
+ */
+class Barrier {
+ public:
+  explicit Barrier(int count) : count_(count), waiting_(0), generation_(0) {}
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    int generation = generation_;
+    if (++waiting_ == count_) {
+      waiting_ = 0;
+      ++generation_;
+      all_arrived_.notify_all();
+    } else {
+      all_arrived_.wait(lock, [&] { return generation != generation_; });
+    }
+  }
+
+ private:
+  int count_;
+  int waiting_;
+  int generation_;
+  std::mutex mutex_;
+  std::condition_variable all_arrived_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Adds items begin ~ end-1 to a DP row with the capacity range split
+ * over threads. Each item reads the whole previous row, so the threads write
+ * to a second row and meet at a barrier before the next item. Chunks start
+ * at multiples of 64, so no two threads write the same word of take bits.
+ * Time complexity: O((end-begin) * capacity / threads)
+ * @param begin: The first item.
+ * @param end: One past the last item.
+ * @param capacity: The largest capacity in the row.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @param row: The DP row, of size capacity + 1.
+ * @param take: If not null, the bit rows of the items, stride words apart.
+ * @param stride: The number of words in one bit row.
+ * @param threads: The number of threads.
+ */
+inline void AddItemsParallel(int begin, int end, int capacity,
+                             const std::vector<int>& value,
+                             const std::vector<int>& weight,
+                             std::vector<int>* row, uint64_t* take,
+                             size_t stride, int threads) {
+  static const AddItemFunc kernel = SelectAddItem();
+  std::vector<int> other_row(capacity + 1);
+  int* rows[2] = {row->data(), other_row.data()};
+  int chunk = ((capacity + threads) / threads + 63) / 64 * 64;
+  Barrier barrier(threads);
+
+  auto work = [&](int t) {
+    int low = std::min(t * chunk, capacity + 1);
+    int high = std::min(low + chunk, capacity + 1);
+    for (int i = begin; i < end; ++i) {
+      const int* from = rows[(i - begin) & 1];
+      int* to = rows[(i - begin + 1) & 1];
+      int first = std::min(std::max(low, std::max(weight[i], 1)), high);
+      std::copy(from + low, from + first, to + low);
+      if (first < high) {
+        kernel(value[i], weight[i], first, high, from, to,
+               take == nullptr ? nullptr : take + (i - begin) * stride,
+               nullptr, nullptr);
+      }
+      barrier.Wait();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; ++t) {
+    workers.emplace_back(work, t);
+  }
+  work(0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if ((end - begin) & 1) {
+    row->swap(other_row);
+  }
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Adds items begin ~ end-1 to the row and backtracks from the given
+ * capacity with one take bit per item and capacity, appending the chosen
+ * items in decreasing order. Time complexity: O((end-begin) * capacity),
+ * memory: (end-begin) * capacity bits.
+ * @param begin: The first item.
+ * @param end: One past the last item.
+ * @param capacity: The capacity to backtrack from.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @param row: The DP row of items 0 ~ begin-1, capacities 0 ~ capacity.
+ * @param result: Used for store the chosen items.
+ * @param threads: The number of threads to split large capacities over.
+ */
+inline void BacktrackWithBits(int begin, int end, int capacity,
+                              const std::vector<int>& value,
+                              const std::vector<int>& weight,
+                              std::vector<int> row, std::vector<int>* result,
+                              int threads = 1) {
+  // Below this many capacities per thread the barrier costs more than the
+  // split saves.
+  const int kMinCapacityPerThread = 1 << 14;
+  threads = std::max(1, std::min(threads, capacity / kMinCapacityPerThread));
+
+  size_t stride = capacity / 64 + 1;
+  std::vector<uint64_t> take((end - begin) * stride, 0);
+  if (threads > 1) {
+    AddItemsParallel(begin, end, capacity, value, weight, &row, take.data(),
+                     stride, threads);
+  } else {
+    for (int i = begin; i < end; ++i) {
+      AddItem(value[i], weight[i], capacity, row.data(),
+              take.data() + (i - begin) * stride, nullptr);
+    }
+  }
+
+  int c = capacity;
+  for (int i = end - 1; i >= begin; --i) {
+    if (take[(i - begin) * stride + (c >> 6)] >> (c & 63) & 1) {
+      result->push_back(i);
+      c -= weight[i];
+    }
+  }
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Finds the items of begin ~ end-1 on the backtracking path which
+ * starts at the given capacity, by splitting the items in halves. One pass
+ * over the second half carries for every capacity the capacity the path
+ * from it has when it reaches the middle, so the halves can be solved
+ * separately with the same choices as a full table. Time complexity:
+ * O((end-begin) * capacity * log(end-begin)), memory: one row per level.
+ * @param begin: The first item.
+ * @param end: One past the last item.
+ * @param capacity: The capacity to backtrack from.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @param row: The DP row of items 0 ~ begin-1, capacities 0 ~ capacity.
+ * @param result: Used for store the chosen items in decreasing order.
+ */
+inline void BacktrackDivideAndConquer(int begin, int end, int capacity,
+                                      const std::vector<int>& value,
+                                      const std::vector<int>& weight,
+                                      const std::vector<int>& row,
+                                      std::vector<int>* result) {
+  // Small enough to keep take bits, which cost fewer bytes than a row.
+  const int kLeafItems = 64;
+  if (end - begin <= kLeafItems) {
+    BacktrackWithBits(begin, end, capacity, value, weight,
+                      std::vector<int>(row.begin(), row.begin() + capacity + 1),
+                      result);
+    return;
+  }
+
+  int mid = begin + (end - begin) / 2;
+  std::vector<int> mid_row(row.begin(), row.begin() + capacity + 1);
+  for (int i = begin; i < mid; ++i) {
+    AddItem(value[i], weight[i], capacity, mid_row.data(), nullptr, nullptr);
+  }
+
+  int mid_capacity;
+  {
+    std::vector<int> end_row(mid_row);
+    std::vector<int> origin(capacity + 1);
+    for (int c = 0; c <= capacity; ++c) {
+      origin[c] = c;
+    }
+    for (int i = mid; i < end; ++i) {
+      AddItem(value[i], weight[i], capacity, end_row.data(), nullptr,
+              origin.data());
+    }
+    mid_capacity = origin[capacity];
+  }
+
+  BacktrackDivideAndConquer(mid, end, capacity, value, weight, mid_row,
+                            result);
+  std::vector<int>().swap(mid_row);
+  BacktrackDivideAndConquer(begin, mid, mid_capacity, value, weight, row,
+                            result);
+}
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implements a function that computes what to pack in a capacity limited
- * knapsack to maximize the total value of all the items packed. Time
- * complexity: O(n * capcacity)
+ * knapsack to maximize the total value of all the items packed. A single DP
+ * row is kept and each item records one take bit per capacity, 1/32 of an
+ * int table. Time complexity: O(n * capacity), memory: n * capacity bits.
  * @param capacity: The capacity of the knapsack.
  * @param value: The value of items.
  * @param weight: The weight of items.
- * @return The indices of the chosen items.
+ * @param threads: The number of threads to split large capacities over, the
+ * result does not depend on it.
+ * @return The indices of the chosen items, in decreasing order.
  */
-std::vector<int> Knapsack(int capacity, const std::vector<int>& value,
-                          const std::vector<int>& weight) {
-  int n = value.size();
-  std::vector<int> row(capacity + 1, 0);
-  std::vector<std::vector<int>> dp(n + 1, row);
-
-  for (int i = 1; i < n + 1; ++i) {
-    for (int c = 1; c < capacity + 1; ++c) {
-      if (weight[i - 1] > c) {
-        // Can not put this in the knapsack.
-        dp[i][c] = dp[i - 1][c];
+std::vector<int> KnapsackWithBits(int capacity, const std::vector<int>& value,
+                                  const std::vector<int>& weight,
+                                  int threads = 1) {
+  std::vector<int> result;
+  BacktrackWithBits(0, value.size(), capacity, value, weight,
+                    std::vector<int>(capacity + 1, 0), &result, threads);
+  return result;
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Same as KnapsackWithBits, but recomputes rows instead of storing
+ * bits for every item. Time complexity: O(n * capacity * log(n)), memory:
+ * O(capacity * log(n)).
+ * @param capacity: The capacity of the knapsack.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @return The indices of the chosen items, in decreasing order.
+ */
+std::vector<int> KnapsackDivideAndConquer(int capacity,
+                                          const std::vector<int>& value,
+                                          const std::vector<int>& weight) {
+  std::vector<int> result;
+  BacktrackDivideAndConquer(0, value.size(), capacity, value, weight,
+                            std::vector<int>(capacity + 1, 0), &result);
+  return result;
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Solves the knapsack by dynamic programming over capacities. Among
+ * equally good packings, later items are left out whenever possible. Take
+ * bits are used while they fit in about 128 MB, otherwise the divide and
+ * conquer. Time complexity: O(n * capacity), times log(n) for the divide and
+ * conquer.
+ * @param capacity: The capacity of the knapsack.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @param threads: The number of threads to split large capacities over when
+ * take bits are used; it has no effect on the divide and conquer above 2^30
+ * cells, which runs on one thread.
+ * @return The indices of the chosen items, in decreasing order.
+ */
+std::vector<int> KnapsackDynamicProgramming(int capacity,
+                                            const std::vector<int>& value,
+                                            const std::vector<int>& weight,
+                                            int threads = 1) {
+  const long long kMaxBits = 1LL << 30;
+  if ((long long)value.size() * ((long long)capacity + 1) <= kMaxBits) {
+    return KnapsackWithBits(capacity, value, weight, threads);
+  }
+
+  return KnapsackDivideAndConquer(capacity, value, weight);
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief A subset of items: its total weight, total value and the chosen
+ * items as a bit mask.
+ */
+struct KnapsackSubset {
+  long long weight;
+  long long value;
+  uint32_t mask;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Lists the Pareto frontier of the subsets of items begin ~ end-1
+ * which fit in the capacity: sorted by weight, each strictly more valuable
+ * than all lighter ones. Every item doubles the list by a linear merge of
+ * the list with and without it, then drops the dominated subsets, so the
+ * list stays sorted without sorting. Time complexity: O(2^(end-begin)).
+ * @param begin: The first item.
+ * @param end: One past the last item, at most begin + 32.
+ * @param capacity: The capacity of the knapsack.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @return The frontier, bit k of a mask stands for item begin + k.
+ */
+inline std::vector<KnapsackSubset> ParetoFrontier(
+    int begin, int end, int capacity, const std::vector<int>& value,
+    const std::vector<int>& weight) {
+  std::vector<KnapsackSubset> frontier = {{0, 0, 0}};
+  std::vector<KnapsackSubset> merged;
+  for (int i = begin; i < end; ++i) {
+    merged.clear();
+    uint32_t bit = 1U << (i - begin);
+    size_t a = 0, b = 0, size = frontier.size();
+    while (a < size || b < size) {
+      if (b < size && frontier[b].weight + weight[i] > capacity) {
+        b = size;
+        continue;
+      }
+
+      // The lighter of the next subsets without and with item i.
+      KnapsackSubset next;
+      if (b < size &&
+          (a == size || frontier[b].weight + weight[i] < frontier[a].weight)) {
+        next = {frontier[b].weight + weight[i], frontier[b].value + value[i],
+                frontier[b].mask | bit};
+        ++b;
       } else {
-        dp[i][c] =
-            std::max(value[i - 1] + dp[i - 1][c - weight[i - 1]], dp[i - 1][c]);
+        next = frontier[a++];
       }
+
+      // Dominated if an earlier, no heavier subset is worth as much.
+      if (!merged.empty() && merged.back().value >= next.value) {
+        continue;
+      }
+      if (!merged.empty() && merged.back().weight == next.weight) {
+        merged.pop_back();
+      }
+      merged.push_back(next);
+    }
+    frontier.swap(merged);
+  }
+
+  return frontier;
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Solves the knapsack by meeting in the middle: the Pareto frontiers
+ * of both halves of the items are listed, then one sweep pairs every subset
+ * of the first half, by increasing weight, with the best subset of the
+ * second half that still fits. Independent of the capacity, for n up to 40.
+ * Time complexity: O(2^(n/2)), memory: O(2^(n/2)).
+ * @param capacity: The capacity of the knapsack.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @return The indices of the chosen items, in decreasing order.
+ */
+std::vector<int> KnapsackMeetInTheMiddle(int capacity,
+                                         const std::vector<int>& value,
+                                         const std::vector<int>& weight) {
+  int n = value.size();
+  int mid = n / 2;
+  std::vector<KnapsackSubset> first =
+      ParetoFrontier(0, mid, capacity, value, weight);
+  std::vector<KnapsackSubset> second =
+      ParetoFrontier(mid, n, capacity, value, weight);
+
+  // The best fitting subset of the second half is the heaviest one that
+  // fits, and it only gets lighter as the first half gets heavier.
+  long long best = -1;
+  uint32_t best_first = 0, best_second = 0;
+  int j = second.size() - 1;
+  for (const KnapsackSubset& subset : first) {
+    while (j >= 0 && subset.weight + second[j].weight > capacity) {
+      --j;
+    }
+    if (j < 0) {
+      break;
+    }
+    if (subset.value + second[j].value > best) {
+      best = subset.value + second[j].value;
+      best_first = subset.mask;
+      best_second = second[j].mask;
     }
   }
 
-  // Find path from the result.
   std::vector<int> result;
-  int i = n, c = capacity;
-  while (dp[i][c] != 0) {
-    // This means item i-1 was put in the knapsack.
-    if (dp[i][c] != dp[i - 1][c]) {
-      result.push_back(i - 1);
-      c -= weight[i - 1];
+  for (int i = n - 1; i >= 0; --i) {
+    bool taken = i < mid ? (best_first >> i & 1)
+                         : (best_second >> (i - mid) & 1);
+    if (taken) {
+      result.push_back(i);
     }
-    --i;
   }
 
   return result;
 }
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Solves the knapsack by best-first branch and bound. Items are
+ * decided in decreasing order of value per weight, and a node is bounded by
+ * the LP relaxation: the remaining capacity filled greedily, the last item
+ * fractionally, which prefix sums give in O(log(n)). The node with the
+ * highest bound is expanded first, and nodes whose bound cannot beat the
+ * best packing found so far are dropped. Independent of the capacity, but
+ * exponential in the worst case.
+ * @param capacity: The capacity of the knapsack.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @return The indices of the chosen items, in decreasing order.
+ */
+std::vector<int> KnapsackBranchAndBound(int capacity,
+                                        const std::vector<int>& value,
+                                        const std::vector<int>& weight) {
+  // Items worth nothing or heavier than the knapsack never help.
+  std::vector<int> order;
+  for (int i = 0; i < (int)value.size(); ++i) {
+    if (value[i] > 0 && weight[i] <= capacity) {
+      order.push_back(i);
+    }
+  }
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    return (long long)value[a] * weight[b] > (long long)value[b] * weight[a];
+  });
+
+  int n = order.size();
+  std::vector<long long> weight_sum(n + 1, 0), value_sum(n + 1, 0);
+  for (int k = 0; k < n; ++k) {
+    weight_sum[k + 1] = weight_sum[k] + weight[order[k]];
+    value_sum[k + 1] = value_sum[k] + value[order[k]];
+  }
+
+  // Bound of a node which has decided items order[0 ~ level-1].
+  auto bound = [&](int level, long long node_weight, long long node_value) {
+    long long room = capacity - node_weight;
+    int full = std::upper_bound(weight_sum.begin() + level, weight_sum.end(),
+                                weight_sum[level] + room) -
+               weight_sum.begin() - 1;
+    double result = node_value + value_sum[full] - value_sum[level];
+    if (full < n) {
+      room -= weight_sum[full] - weight_sum[level];
+      result += (double)room * value[order[full]] / weight[order[full]];
+    }
+    return result;
+  };
+
+  struct Node {
+    int level;
+    long long weight;
+    long long value;
+    int parent;
+    bool taken;
+  };
+  std::vector<Node> nodes = {{0, 0, 0, -1, false}};
+  std::priority_queue<std::pair<double, int>> queue;
+  queue.push({bound(0, 0, 0), 0});
+
+  long long best = 0;
+  int best_node = 0;
+  while (!queue.empty()) {
+    double node_bound = queue.top().first;
+    int index = queue.top().second;
+    queue.pop();
+    if (std::floor(node_bound + 1e-9) <= best) {
+      break;
+    }
+
+    Node node = nodes[index];
+    if (node.level == n) {
+      continue;
+    }
+
+    int item = order[node.level];
+    Node children[2] = {
+        {node.level + 1, node.weight + weight[item], node.value + value[item],
+         index, true},
+        {node.level + 1, node.weight, node.value, index, false}};
+    for (const Node& child : children) {
+      if (child.weight > capacity) {
+        continue;
+      }
+
+      // Leaving out all undecided items gives a packing already.
+      bool improves = child.value > best;
+      if (improves) {
+        best = child.value;
+      }
+      double child_bound = bound(child.level, child.weight, child.value);
+      bool promising = std::floor(child_bound + 1e-9) > best;
+      if (improves || promising) {
+        nodes.push_back(child);
+        if (improves) {
+          best_node = nodes.size() - 1;
+        }
+        if (promising) {
+          queue.push({child_bound, nodes.size() - 1});
+        }
+      }
+    }
+  }
+
+  std::vector<int> result;
+  for (int index = best_node; index > 0; index = nodes[index].parent) {
+    if (nodes[index].taken) {
+      result.push_back(order[nodes[index].level - 1]);
+    }
+  }
+  std::sort(result.rbegin(), result.rend());
+
+  return result;
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Implements a function that computes what to pack in a capacity limited
+ * knapsack to maximize the total value of all the items packed. The dynamic
+ * programming is used while n * capacity is small; beyond that meet in the
+ * middle for n up to 40, then the dynamic programming again while it stays on
+ * take bits (at most 2^30 cells) and the bits and rows fit in 512 MB, and
+ * branch and bound for anything larger.
+ * @param capacity: The capacity of the knapsack.
+ * @param value: The value of items.
+ * @param weight: The weight of items.
+ * @param threads: The number of threads to split large capacities over when
+ * the dynamic programming is used.
+ * @return The indices of the chosen items, in decreasing order.
+ */
+std::vector<int> Knapsack(int capacity, const std::vector<int>& value,
+                          const std::vector<int>& weight, int threads = 1) {
+  const long long kSmallCells = 1LL << 27;
+  const long long kMaxCells = 1LL << 30;
+  const long long kMaxBytes = 1LL << 29;
+  const int kMaxMeetInTheMiddleItems = 40;
+
+  int n = value.size();
+  long long cells = (long long)n * ((long long)capacity + 1);
+  // One take bit per cell, and the row plus a second one when threaded.
+  long long bytes = cells / 8 + 2 * sizeof(int) * ((long long)capacity + 1);
+  if (cells <= kSmallCells && bytes <= kMaxBytes) {
+    return KnapsackDynamicProgramming(capacity, value, weight, threads);
+  }
+  if (n <= kMaxMeetInTheMiddleItems) {
+    return KnapsackMeetInTheMiddle(capacity, value, weight);
+  }
+  if (cells <= kMaxCells && bytes <= kMaxBytes) {
+    return KnapsackDynamicProgramming(capacity, value, weight, threads);
+  }
+
+  return KnapsackBranchAndBound(capacity, value, weight);
+}
+
 }  // namespace zhoni04
 }  // namespace aaps
 
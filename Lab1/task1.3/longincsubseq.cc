@@ -1,61 +1,127 @@
 #include <algorithm>
 #include <cstdio>
-#include <stack>
 #include <vector>
 
 namespace aaps {
 namespace zhoni04 {
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Finds the first of n sorted values which is not less than x, without
+ * a branch in the loop: each step moves the base by a conditional move.
+ * Time complexity: O(log(n)).
+ * @param values: The sorted values.
+ * @param n: The number of values.
+ * @param x: The value to search for.
+ * @return The index of the first value not less than x, n if none.
+ */
+inline int LowerBound(const int* values, int n, int x) {
+  if (n == 0) {
+    return 0;
+  }
+
+  const int* base = values;
+  while (n > 1) {
+    int half = n / 2;
+    base = base[half] < x ? base + half : base;
+    n -= half;
+  }
+
+  return (base - values) + (*base < x);
+}
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implements a function that computes the longest increasing subsequence
- * in a given sequence. The algorithm is based on patience sorting. Time
- * complexity: O(nlog(n)).
+ * in a given sequence. The algorithm is based on patience sorting, keeping
+ * only the top of each pile: tail_values[k] is the smallest value ending an
+ * increasing subsequence of length k + 1, which is sorted, and tails[k] is
+ * its index. Time complexity: O(nlog(n)).
  * @param sequence: The given sequence.
  * @return The indices of a longest increasing subsequences.
  */
 std::vector<int> Lis(const std::vector<int>& sequence) {
   int n = sequence.size();
   std::vector<int> predecessor(n);
-  std::vector<std::stack<int>> piles(n);
-
-  int non_empty_piles = 0;
+  std::vector<int> tail_values(n);
+  std::vector<int> tails(n);
 
+  int piles = 0;
   for (int i = 0; i < n; ++i) {
-    // Binary search, find a pile to put current number.
-    int left = 0;
-    int right = non_empty_piles - 1;
-    while (left <= right) {
-      int mid = (left + right) / 2;
-      if (sequence[piles[mid].top()] < sequence[i]) {
-        left = mid + 1;
-      } else {
-        right = mid - 1;
-      }
-    }
+    int pile = LowerBound(tail_values.data(), piles, sequence[i]);
+    tail_values[pile] = sequence[i];
+    tails[pile] = i;
+    predecessor[i] = pile > 0 ? tails[pile - 1] : -1;
+    piles = std::max(piles, pile + 1);
+  }
+
+  std::vector<int> result(piles);
+  int curr = piles > 0 ? tails[piles - 1] : -1;
+  for (int i = piles - 1; i >= 0; --i) {
+    result[i] = curr;
+    curr = predecessor[curr];
+  }
+
+  return result;
+}
 
-    piles[left].push(i);
-    if (left - 1 >= 0) {
-      predecessor[i] = piles[left - 1].top();
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class OnlineLis
+ * @brief Implements the longest increasing subsequence of a sequence which
+ * grows one element at a time, with the same tails arrays as Lis. The length
+ * is known after every element and a subsequence is rebuilt only when asked.
+ */
+class OnlineLis {
+ public:
+  /**
+   * @brief Appends an element to the sequence. Time complexity: O(log(n)).
+   * @param value: The element.
+   * @return The length of the longest increasing subsequence ending at it.
+   */
+  int Add(int value) {
+    int i = predecessor_.size();
+    int pile = LowerBound(tail_values_.data(), tail_values_.size(), value);
+    if (pile == (int)tail_values_.size()) {
+      tail_values_.push_back(value);
+      tails_.push_back(i);
     } else {
-      predecessor[i] = -1;
+      tail_values_[pile] = value;
+      tails_[pile] = i;
     }
+    predecessor_.push_back(pile > 0 ? tails_[pile - 1] : -1);
 
-    if (left >= non_empty_piles) {
-      ++non_empty_piles;
-    }
+    return pile + 1;
   }
 
-  std::vector<int> result(non_empty_piles);
-  int curr = piles[non_empty_piles - 1].top();
+  /**
+   * @brief Gets the length of a longest increasing subsequence so far. Time
+   * complexity: O(1).
+   * @return The length.
+   */
+  int length() const { return tails_.size(); }
 
-  for (int i = non_empty_piles - 1; i >= 0; --i) {
-    result[i] = curr;
-    curr = predecessor[curr];
+  /**
+   * @brief Rebuilds a longest increasing subsequence of the elements added so
+   * far, the same one Lis would give. Time complexity: O(length).
+   * @return Its indices in the sequence, in increasing order.
+   */
+  std::vector<int> Indices() const {
+    std::vector<int> result(tails_.size());
+    int curr = tails_.empty() ? -1 : tails_.back();
+    for (int i = result.size() - 1; i >= 0; --i) {
+      result[i] = curr;
+      curr = predecessor_[curr];
+    }
+
+    return result;
   }
 
-  return result;
-}
+ private:
+  std::vector<int> predecessor_;
+  std::vector<int> tail_values_;
+  std::vector<int> tails_;
+};
 
 }  // namespace zhoni04
 }  // namespace aaps
@@ -9,15 +9,36 @@ namespace zhoni04 {
  * @class FenwickTree
  * @brief Implements a Fenwick Tree based on array, this class supports
  * operations of two types: (a) increment an element in the array or (b) query
- * the prefix sum of a portion of the array.
+ * the prefix sum of a portion of the array. It can also be built from an
+ * existing array in linear time and find the position where a prefix sum is
+ * first reached.
+ * @tparam T: The value type.
  */
+template <typename T = long long>
 class FenwickTree {
  public:
   /**
-   * @brief Initializes a new instance of Fenwick Tree.
+   * @brief Initializes a new instance of Fenwick Tree with all zeros.
    * @param n: The length of the array, assumed to be positive.
    */
-  explicit FenwickTree(int n) : n_(n + 1), arr_(n_, 0) {}
+  explicit FenwickTree(int n) : n_(n), arr_(n_ + 1, 0) {}
+
+  /**
+   * @brief Initializes a new instance of Fenwick Tree from the given array.
+   * Each node pushes its partial sum to its parent once, so the time
+   * complexity is O(n) instead of O(nlog(n)) for n calls of Add.
+   * @param values: The initial array.
+   */
+  explicit FenwickTree(const std::vector<T>& values)
+      : n_(values.size()), arr_(n_ + 1, 0) {
+    for (int i = 1; i <= n_; ++i) {
+      arr_[i] += values[i - 1];
+      int parent = i + (i & -i);
+      if (parent <= n_) {
+        arr_[parent] += arr_[i];
+      }
+    }
+  }
 
   /**
    * @brief Increases array value at index with delta. Time complexity:
@@ -25,7 +46,7 @@ class FenwickTree {
    * @param index: The index, assumed to be between 0 ~ n-1 (both inclusive).
    * @param delta: The delta.
    */
-  void Add(int index, int delta) {
+  void Add(int index, T delta) {
     int i = index + 1;
 
     while (i <= n_) {
@@ -40,8 +61,8 @@ class FenwickTree {
    * @param index: The index, assumed to be between 0 ~ n (both inclusive).
    * @return The sum.
    */
-  long long Sum(int index) const {
-    long long sum = 0;
+  T Sum(int index) const {
+    T sum = 0;
 
     while (index > 0) {
       sum += arr_[index];
@@ -51,15 +72,117 @@ class FenwickTree {
     return sum;
   }
 
+  /**
+   * @brief Finds the smallest index such that the sum of array value from
+   * index 0 to index (inclusive) is not less than prefix, assumed all values
+   * are non-negative. With 0/1 values, LowerBound(k) is the index of the k-th
+   * one. Time complexity: O(log(n)).
+   * @param prefix: The prefix sum to reach.
+   * @return The index, or n if the total sum is less than prefix.
+   */
+  int LowerBound(T prefix) const {
+    if (prefix <= 0) {
+      return 0;
+    }
+
+    int pos = 0;
+    int step = 1;
+    while (step * 2 <= n_) {
+      step *= 2;
+    }
+
+    // Descend the implicit tree: arr_[pos + step] is the sum of the next step
+    // values after pos.
+    for (; step > 0; step /= 2) {
+      if (pos + step <= n_ && arr_[pos + step] < prefix) {
+        pos += step;
+        prefix -= arr_[pos];
+      }
+    }
+
+    return pos;
+  }
+
  private:
   int n_;
-  std::vector<long long> arr_;
+  std::vector<T> arr_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class RangeFenwickTree
+ * @brief Implements a Fenwick Tree which supports adding a delta to a range of
+ * the array and querying prefix sums. It keeps two trees of difference
+ * values, the prefix sum of the first 'index' values is
+ * index * first.Sum(index) - second.Sum(index).
+ * @tparam T: The value type.
+ */
+template <typename T = long long>
+class RangeFenwickTree {
+ public:
+  /**
+   * @brief Initializes a new instance of range Fenwick Tree with all zeros.
+   * @param n: The length of the array, assumed to be positive.
+   */
+  explicit RangeFenwickTree(int n) : first_(n + 1), second_(n + 1) {}
+
+  /**
+   * @brief Initializes a new instance of range Fenwick Tree from the given
+   * array. Time complexity: O(n).
+   * @param values: The initial array.
+   */
+  explicit RangeFenwickTree(const std::vector<T>& values)
+      : first_(Differences(values, false)),
+        second_(Differences(values, true)) {}
+
+  /**
+   * @brief Increases array values from index begin to index end-1 with delta.
+   * Time complexity: O(log(n)).
+   * @param begin: The first index, assumed to be between 0 ~ n.
+   * @param end: The index after the last, assumed to be between begin ~ n.
+   * @param delta: The delta.
+   */
+  void AddRange(int begin, int end, T delta) {
+    first_.Add(begin, delta);
+    first_.Add(end, -delta);
+    second_.Add(begin, delta * begin);
+    second_.Add(end, -delta * end);
+  }
+
+  /**
+   * @brief Computes the sum of array value from index 0 to index-1. Time
+   * complexity: O(log(n)).
+   * @param index: The index, assumed to be between 0 ~ n (both inclusive).
+   * @return The sum.
+   */
+  T Sum(int index) const {
+    return first_.Sum(index) * index - second_.Sum(index);
+  }
+
+ private:
+  static std::vector<T> Differences(const std::vector<T>& values,
+                                    bool weighted) {
+    int n = values.size();
+    std::vector<T> diff(n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+      T d = values[i] - (i > 0 ? values[i - 1] : 0);
+      diff[i] = weighted ? d * i : d;
+    }
+    if (n > 0) {
+      diff[n] = weighted ? -values[n - 1] * n : -values[n - 1];
+    }
+
+    return diff;
+  }
+
+  FenwickTree<T> first_;
+  FenwickTree<T> second_;
 };
 
 }  // namespace zhoni04
 }  // namespace aaps
 
-using FenwickTree = aaps::zhoni04::FenwickTree;
+using FenwickTree = aaps::zhoni04::FenwickTree<long long>;
 
 int main(void) {
   int N, Q;
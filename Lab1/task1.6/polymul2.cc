@@ -1,11 +1,612 @@
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <complex>
+#include <cstdint>
 #include <cstdio>
+#include <thread>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
 namespace aaps {
 namespace zhoni04 {
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief The butterfly kernels FftPlan can run on. kAuto picks the widest one
+ * the CPU supports at runtime; a kernel which is not supported falls back to
+ * kScalar.
+ */
+enum class FftKernel { kAuto, kScalar, kAvx2, kAvx512 };
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AAPS_FFT_X86 1
+#endif
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class FftPlan
+ * @brief Implements an iterative radix-2 Fast Fourier Transformation working
+ * in place on a caller-owned buffer. The plan caches the twiddle factors and
+ * the bit-reversal permutation of every size it has seen, so that repeated
+ * transforms do no allocation and no repeated trigonometry. Butterflies run
+ * on an AVX2 or AVX-512 kernel when available, and large transforms can be
+ * split over several threads: the first levels work on independent
+ * sub-arrays, one per thread, and each of the last log2(threads) levels
+ * splits its twiddle range across the threads.
+ */
+class FftPlan {
+ public:
+  /**
+   * @brief Initializes a new instance of FFT plan.
+   * @param threads: The number of threads to use for large transforms.
+   * @param kernel: The butterfly kernel to use.
+   */
+  explicit FftPlan(int threads = 1, FftKernel kernel = FftKernel::kAuto)
+      : threads_(std::max(threads, 1)), butterflies_(SelectKernel(kernel)) {}
+
+  /**
+   * @brief Transforms the first n values of data in place. Time complexity:
+   * O(nlog(n)), plus O(n) the first time a size is seen.
+   * @param data: The values, assumed to hold at least n values.
+   * @param n: The transform size, assumed to be a power of 2.
+   * @param inverse: True for the inverse transform, which includes the
+   * division by n.
+   */
+  void Transform(std::complex<double>* data, int n, bool inverse) {
+    Prepare(n);
+
+    // Small transforms are not worth a thread each.
+    int threads = 1;
+    while (threads * 2 <= threads_ && n / (threads * 2) >= kMinChunk) {
+      threads *= 2;
+    }
+    int chunk = n / threads;
+
+    const std::vector<int>& reverse = reverse_[Log2(n)];
+    ParallelFor(threads, [&](int t) {
+      for (int i = t * chunk; i < (t + 1) * chunk; ++i) {
+        if (i < reverse[i]) {
+          std::swap(data[i], data[reverse[i]]);
+        }
+      }
+    });
+
+    // roots_[half + k] is exp(2*pi*i*k / (2*half)), so each level reads one
+    // contiguous slice.
+    const std::complex<double>* roots =
+        inverse ? inverse_roots_.data() : roots_.data();
+
+    ParallelFor(threads, [&](int t) {
+      std::complex<double>* sub = data + t * chunk;
+      for (int half = 1; half < chunk; half *= 2) {
+        butterflies_(sub, roots, half, chunk / (2 * half), 0, half);
+      }
+    });
+
+    for (int half = chunk; half < n; half *= 2) {
+      int k_chunk = half / threads;
+      ParallelFor(threads, [&](int t) {
+        butterflies_(data, roots, half, n / (2 * half), t * k_chunk,
+                     (t + 1) * k_chunk);
+      });
+    }
+
+    if (inverse) {
+      ParallelFor(threads, [&](int t) {
+        for (int i = t * chunk; i < (t + 1) * chunk; ++i) {
+          data[i] /= n;
+        }
+      });
+    }
+  }
+
+ private:
+  // Runs butterflies of the given level on blocks 0 ~ blocks-1, for twiddle
+  // indices k_begin ~ k_end-1 of each block.
+  using ButterfliesFunc = void (*)(std::complex<double>* data,
+                                   const std::complex<double>* roots, int half,
+                                   int blocks, int k_begin, int k_end);
+
+  static const int kMinChunk = 1 << 15;
+
+  static void ButterfliesScalar(std::complex<double>* data,
+                                const std::complex<double>* roots, int half,
+                                int blocks, int k_begin, int k_end) {
+    for (int block = 0; block < blocks; ++block) {
+      std::complex<double>* x = data + block * 2 * half;
+      for (int k = k_begin; k < k_end; ++k) {
+        std::complex<double> u = x[k];
+        std::complex<double> v = x[k + half] * roots[half + k];
+        x[k] = u + v;
+        x[k + half] = u - v;
+      }
+    }
+  }
+
+#ifdef AAPS_FFT_X86
+  // Two complex values per register: [re0, im0, re1, im1].
+  __attribute__((target("avx2,fma"))) static void ButterfliesAvx2(
+      std::complex<double>* data, const std::complex<double>* roots, int half,
+      int blocks, int k_begin, int k_end) {
+    if (half < 2) {
+      ButterfliesScalar(data, roots, half, blocks, k_begin, k_end);
+      return;
+    }
+
+    const double* w_base = reinterpret_cast<const double*>(roots + half);
+    for (int block = 0; block < blocks; ++block) {
+      double* x = reinterpret_cast<double*>(data + block * 2 * half);
+      double* y = x + 2 * half;
+      for (int k = k_begin; k < k_end; k += 2) {
+        __m256d w = _mm256_loadu_pd(w_base + 2 * k);
+        __m256d d = _mm256_loadu_pd(y + 2 * k);
+        __m256d w_re = _mm256_movedup_pd(w);
+        __m256d w_im = _mm256_permute_pd(w, 0xF);
+        __m256d d_swap = _mm256_permute_pd(d, 0x5);
+        __m256d v = _mm256_fmaddsub_pd(d, w_re, _mm256_mul_pd(d_swap, w_im));
+        __m256d u = _mm256_loadu_pd(x + 2 * k);
+        _mm256_storeu_pd(x + 2 * k, _mm256_add_pd(u, v));
+        _mm256_storeu_pd(y + 2 * k, _mm256_sub_pd(u, v));
+      }
+    }
+  }
+
+  // Four complex values per register.
+  __attribute__((target("avx512f"))) static void ButterfliesAvx512(
+      std::complex<double>* data, const std::complex<double>* roots, int half,
+      int blocks, int k_begin, int k_end) {
+    if (half < 4) {
+      ButterfliesScalar(data, roots, half, blocks, k_begin, k_end);
+      return;
+    }
+
+    const double* w_base = reinterpret_cast<const double*>(roots + half);
+    for (int block = 0; block < blocks; ++block) {
+      double* x = reinterpret_cast<double*>(data + block * 2 * half);
+      double* y = x + 2 * half;
+      for (int k = k_begin; k < k_end; k += 4) {
+        __m512d w = _mm512_loadu_pd(w_base + 2 * k);
+        __m512d d = _mm512_loadu_pd(y + 2 * k);
+        // The masked forms with a full mask avoid the unmasked ones, whose
+        // _mm512_undefined_pd() source trips -Wmaybe-uninitialized in GCC.
+        __m512d w_re = _mm512_mask_movedup_pd(w, 0xFF, w);
+        __m512d w_im = _mm512_mask_permute_pd(w, 0xFF, w, 0xFF);
+        __m512d d_swap = _mm512_mask_permute_pd(d, 0xFF, d, 0x55);
+        __m512d v = _mm512_fmaddsub_pd(d, w_re, _mm512_mul_pd(d_swap, w_im));
+        __m512d u = _mm512_loadu_pd(x + 2 * k);
+        _mm512_storeu_pd(x + 2 * k, _mm512_add_pd(u, v));
+        _mm512_storeu_pd(y + 2 * k, _mm512_sub_pd(u, v));
+      }
+    }
+  }
+#endif
+
+  static ButterfliesFunc SelectKernel(FftKernel kernel) {
+#ifdef AAPS_FFT_X86
+    bool avx512 = __builtin_cpu_supports("avx512f");
+    bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if ((kernel == FftKernel::kAuto || kernel == FftKernel::kAvx512) &&
+        avx512) {
+      return ButterfliesAvx512;
+    }
+    if ((kernel == FftKernel::kAuto || kernel == FftKernel::kAvx2 ||
+         kernel == FftKernel::kAvx512) &&
+        avx2) {
+      return ButterfliesAvx2;
+    }
+#endif
+    return ButterfliesScalar;
+  }
+
+  // Runs func(0) ~ func(threads-1), one per thread, and waits for all.
+  template <typename Func>
+  static void ParallelFor(int threads, const Func& func) {
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t) {
+      workers.emplace_back(func, t);
+    }
+    func(0);
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  static int Log2(int n) {
+    int log = 0;
+    while ((1 << log) < n) {
+      ++log;
+    }
+
+    return log;
+  }
+
+  void Prepare(int n) {
+    if ((int)roots_.size() < n) {
+      const double kPi = std::acos(-1);
+      int half = roots_.empty() ? 1 : roots_.size();
+      roots_.resize(n);
+      inverse_roots_.resize(n);
+      // Each twiddle is computed directly rather than by repeated
+      // multiplication, so the error does not grow with n.
+      for (; half < n; half *= 2) {
+        for (int k = 0; k < half; ++k) {
+          double angle = kPi * k / half;
+          roots_[half + k] = std::complex<double>(cos(angle), sin(angle));
+          inverse_roots_[half + k] = std::conj(roots_[half + k]);
+        }
+      }
+    }
+
+    int log = Log2(n);
+    if ((int)reverse_.size() <= log) {
+      reverse_.resize(log + 1);
+    }
+
+    std::vector<int>& reverse = reverse_[log];
+    if (reverse.empty()) {
+      reverse.resize(n);
+      reverse[0] = 0;
+      for (int i = 1; i < n; ++i) {
+        reverse[i] = (reverse[i >> 1] >> 1) | ((i & 1) << (log - 1));
+      }
+    }
+  }
+
+  int threads_;
+  ButterfliesFunc butterflies_;
+  std::vector<std::complex<double>> roots_;
+  std::vector<std::complex<double>> inverse_roots_;
+  std::vector<std::vector<int>> reverse_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class NttPlan
+ * @brief Implements the Number Theoretic Transform, the FFT over the integers
+ * modulo a prime kMod = c * 2^k + 1, which is exact. Like FftPlan it works in
+ * place and caches roots and bit-reversal tables per size. The roots are kept
+ * in Montgomery form (w * 2^32 mod kMod), so a butterfly multiplies by a root
+ * with one Montgomery reduction instead of a 64-bit division, while the data
+ * stays in plain residues.
+ * @tparam kMod: The prime modulus, below 2^31 so that the sum of two residues
+ * fits in 32 bits; kMod - 1 must be divisible by the transform sizes.
+ * @tparam kPrimitiveRoot: A primitive root modulo kMod.
+ */
+template <uint32_t kMod, uint32_t kPrimitiveRoot>
+class NttPlan {
+ public:
+  static const uint32_t kModulus = kMod;
+
+  /**
+   * @brief Transforms the first n residues of data in place. Time complexity:
+   * O(nlog(n)), plus O(n) the first time a size is seen.
+   * @param data: The residues, assumed to be in 0 ~ kMod-1.
+   * @param n: The transform size, assumed to be a power of 2.
+   * @param inverse: True for the inverse transform, which includes the
+   * division by n.
+   */
+  void Transform(uint32_t* data, int n, bool inverse) {
+    Prepare(n);
+
+    const std::vector<int>& reverse = reverse_[Log2(n)];
+    for (int i = 0; i < n; ++i) {
+      if (i < reverse[i]) {
+        std::swap(data[i], data[reverse[i]]);
+      }
+    }
+
+    const std::vector<uint32_t>& roots = inverse ? inverse_roots_ : roots_;
+    for (int half = 1; half < n; half *= 2) {
+      for (int begin = 0; begin < n; begin += 2 * half) {
+        for (int k = 0; k < half; ++k) {
+          uint32_t u = data[begin + k];
+          uint32_t v =
+              Reduce((uint64_t)data[begin + k + half] * roots[half + k]);
+          data[begin + k] = u + v >= kMod ? u + v - kMod : u + v;
+          data[begin + k + half] = u >= v ? u - v : u + kMod - v;
+        }
+      }
+    }
+
+    if (inverse) {
+      // Reduce(x * (n^-1 * R)) = x / n.
+      uint64_t n_inverse = ToMontgomery(Power(n, kMod - 2));
+      for (int i = 0; i < n; ++i) {
+        data[i] = Reduce(data[i] * n_inverse);
+      }
+    }
+  }
+
+  /**
+   * @brief Computes the cyclic convolution of the first n residues of a and b
+   * into a, modulo kMod; b is overwritten. The forward transforms are done by
+   * decimation in frequency, which leaves the spectrum in bit-reversed order,
+   * and the inverse by decimation in time, which accepts that order. So no
+   * bit-reversal pass is needed at all. Time complexity: O(nlog(n)).
+   * @param a: The first residues, and the result.
+   * @param b: The second residues.
+   * @param n: The transform size, assumed to be a power of 2.
+   */
+  void Convolve(uint32_t* a, uint32_t* b, int n) {
+    Prepare(n);
+
+    ForwardToBitReversed(a, n);
+    ForwardToBitReversed(b, n);
+
+    // Reduce(a * b) drops a factor R, which the final scaling puts back.
+    for (int i = 0; i < n; ++i) {
+      a[i] = Reduce((uint64_t)a[i] * b[i]);
+    }
+
+    for (int half = 1; half < n; half *= 2) {
+      for (int begin = 0; begin < n; begin += 2 * half) {
+        for (int k = 0; k < half; ++k) {
+          uint32_t u = a[begin + k];
+          uint32_t v =
+              Reduce((uint64_t)a[begin + k + half] * inverse_roots_[half + k]);
+          a[begin + k] = u + v >= kMod ? u + v - kMod : u + v;
+          a[begin + k + half] = u >= v ? u - v : u + kMod - v;
+        }
+      }
+    }
+
+    // Reduce(x * (n^-1 * R^2)) = x * R / n.
+    uint64_t scale = ToMontgomery(ToMontgomery(Power(n, kMod - 2)));
+    for (int i = 0; i < n; ++i) {
+      a[i] = Reduce(a[i] * scale);
+    }
+  }
+
+  /**
+   * @brief Computes base^exponent modulo kMod. Time complexity:
+   * O(log(exponent)).
+   * @param base: The base.
+   * @param exponent: The exponent.
+   * @return The power.
+   */
+  static uint32_t Power(uint64_t base, uint64_t exponent) {
+    uint64_t result = 1;
+    base %= kMod;
+    while (exponent > 0) {
+      if (exponent & 1) {
+        result = result * base % kMod;
+      }
+      base = base * base % kMod;
+      exponent >>= 1;
+    }
+
+    return result;
+  }
+
+ private:
+  static int Log2(int n) {
+    int log = 0;
+    while ((1 << log) < n) {
+      ++log;
+    }
+
+    return log;
+  }
+
+  // -kMod^-1 modulo 2^32, by Newton iteration on the inverse.
+  static constexpr uint32_t NegativeInverse() {
+    uint32_t inverse = kMod;
+    for (int i = 0; i < 4; ++i) {
+      inverse *= 2 - kMod * inverse;
+    }
+
+    return -inverse;
+  }
+
+  static const uint32_t kNegativeInverse = NegativeInverse();
+  static const uint64_t kR = (1ULL << 32) % kMod;
+
+  // Returns t * 2^-32 modulo kMod, assumed t < kMod * 2^32.
+  static uint32_t Reduce(uint64_t t) {
+    uint32_t m = (uint32_t)t * kNegativeInverse;
+    uint32_t u = (t + (uint64_t)m * kMod) >> 32;
+    return u >= kMod ? u - kMod : u;
+  }
+
+  static uint32_t ToMontgomery(uint64_t x) { return x * kR % kMod; }
+
+  void ForwardToBitReversed(uint32_t* data, int n) {
+    for (int half = n / 2; half >= 1; half /= 2) {
+      for (int begin = 0; begin < n; begin += 2 * half) {
+        for (int k = 0; k < half; ++k) {
+          uint32_t u = data[begin + k];
+          uint32_t v = data[begin + k + half];
+          data[begin + k] = u + v >= kMod ? u + v - kMod : u + v;
+          data[begin + k + half] = Reduce(
+              (uint64_t)(u >= v ? u - v : u + kMod - v) * roots_[half + k]);
+        }
+      }
+    }
+  }
+
+  void Prepare(int n) {
+    if ((int)roots_.size() < n) {
+      int half = roots_.empty() ? 1 : (int)roots_.size();
+      roots_.resize(n);
+      inverse_roots_.resize(n);
+      for (; half < n; half *= 2) {
+        uint64_t step = Power(kPrimitiveRoot, (kMod - 1) / (2 * half));
+        uint64_t inverse_step = Power(step, kMod - 2);
+        uint64_t w = 1, inverse_w = 1;
+        for (int k = 0; k < half; ++k) {
+          roots_[half + k] = ToMontgomery(w);
+          inverse_roots_[half + k] = ToMontgomery(inverse_w);
+          w = w * step % kMod;
+          inverse_w = inverse_w * inverse_step % kMod;
+        }
+      }
+    }
+
+    int log = Log2(n);
+    if ((int)reverse_.size() <= log) {
+      reverse_.resize(log + 1);
+    }
+
+    std::vector<int>& reverse = reverse_[log];
+    if (reverse.empty()) {
+      reverse.resize(n);
+      reverse[0] = 0;
+      for (int i = 1; i < n; ++i) {
+        reverse[i] = (reverse[i >> 1] >> 1) | ((i & 1) << (log - 1));
+      }
+    }
+  }
+
+  std::vector<uint32_t> roots_;
+  std::vector<uint32_t> inverse_roots_;
+  std::vector<std::vector<int>> reverse_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class ExactMultiplier
+ * @brief Implements exact multiplication of integer polynomials. The product
+ * is computed by NTT modulo up to three primes below 2^31 and combined by the
+ * Chinese remainder theorem (Garner's form). Three primes recover every
+ * coefficient whose absolute value is below about 8.5 * 10^26, so any product
+ * which fits in 64 bits is exact; when the input bounds allow it, only one or
+ * two primes are used. All three primes are 1 modulo 2^26, so products of up
+ * to kMaxLength = 2^26 coefficients are supported. The plans are kept between
+ * calls.
+ *
+ * This is not a faster replacement for the double FFT of Polynomial: with one
+ * prime it is somewhat faster, but with two or three primes it is 1.5 ~ 3
+ * times slower at n >= 2^20. Use it when the FFT rounding would give wrong
+ * coefficients.
+ */
+class ExactMultiplier {
+ public:
+  static const uint32_t kMod1 = 2013265921;  // 15 * 2^27 + 1
+  static const uint32_t kMod2 = 1811939329;  // 27 * 2^26 + 1
+  static const uint32_t kMod3 = 469762049;   // 7 * 2^26 + 1
+  static const int kMaxLength = 1 << 26;
+
+  /**
+   * @brief Multiplies two integer polynomials exactly. Time complexity:
+   * O(nlog(n)).
+   * @param a: The coefficients of the first polynomial, a[i] belongs to xi.
+   * @param b: The coefficients of the second polynomial.
+   * @return The coefficients of the product, assumed to fit in 64 bits; empty
+   * if the product has more than kMaxLength coefficients.
+   */
+  std::vector<int64_t> Multiply(const std::vector<int64_t>& a,
+                                const std::vector<int64_t>& b) {
+    if ((int64_t)a.size() + (int64_t)b.size() - 1 > kMaxLength) {
+      return std::vector<int64_t>();
+    }
+
+    int max_degree = a.size() + b.size() - 1;
+    int n = 1;
+    while (n < max_degree) {
+      n <<= 1;
+    }
+
+    // Use only as many primes as the largest possible coefficient needs.
+    int primes = CountPrimesNeeded(a, b);
+
+    MultiplyModulo(&plan1_, a, b, n, &r1_);
+    if (primes >= 2) {
+      MultiplyModulo(&plan2_, a, b, n, &r2_);
+    }
+    if (primes >= 3) {
+      MultiplyModulo(&plan3_, a, b, n, &r3_);
+    }
+
+    const uint64_t m1_inverse_mod_m2 = Plan2::Power(kMod1, kMod2 - 2);
+    const uint64_t m12_inverse_mod_m3 =
+        Plan3::Power((uint64_t)kMod1 * kMod2 % kMod3, kMod3 - 2);
+    const __int128 m12 = (__int128)kMod1 * kMod2;
+    const __int128 m123 = m12 * kMod3;
+
+    std::vector<int64_t> result(max_degree);
+    for (int i = 0; i < max_degree; ++i) {
+      if (primes == 1) {
+        result[i] = r1_[i] > kMod1 / 2 ? (int64_t)r1_[i] - kMod1 : r1_[i];
+        continue;
+      }
+
+      // x = r1 + m1 * t2 + m1 * m2 * t3, with 0 <= x < m1 * m2 * m3.
+      uint64_t t2 = (r2_[i] + kMod2 - r1_[i] % kMod2) % kMod2 *
+                    m1_inverse_mod_m2 % kMod2;
+      if (primes == 2) {
+        int64_t x = r1_[i] + (int64_t)kMod1 * t2;
+        result[i] = x > m12 / 2 ? x - (int64_t)m12 : x;
+        continue;
+      }
+
+      uint64_t x12_mod_m3 = (r1_[i] + (uint64_t)kMod1 % kMod3 * t2) % kMod3;
+      uint64_t t3 =
+          (r3_[i] + kMod3 - x12_mod_m3) % kMod3 * m12_inverse_mod_m3 % kMod3;
+      __int128 x = r1_[i] + (__int128)kMod1 * t2 + m12 * t3;
+
+      // Residues above the middle represent negative coefficients.
+      if (x > m123 / 2) {
+        x -= m123;
+      }
+      result[i] = (int64_t)x;
+    }
+
+    return result;
+  }
+
+ private:
+  using Plan1 = NttPlan<kMod1, 31>;
+  using Plan2 = NttPlan<kMod2, 13>;
+  using Plan3 = NttPlan<kMod3, 3>;
+
+  static int CountPrimesNeeded(const std::vector<int64_t>& a,
+                               const std::vector<int64_t>& b) {
+    long double max_a = 0, max_b = 0;
+    for (auto c : a) {
+      max_a = std::max(max_a, std::fabs((long double)c));
+    }
+    for (auto c : b) {
+      max_b = std::max(max_b, std::fabs((long double)c));
+    }
+
+    // A coefficient of the product is a sum of at most min(|a|, |b|) terms.
+    long double bound = max_a * max_b * std::min(a.size(), b.size());
+    if (2 * bound < kMod1) {
+      return 1;
+    } else if (2 * bound < (long double)kMod1 * kMod2) {
+      return 2;
+    }
+
+    return 3;
+  }
+
+  template <typename Plan>
+  void MultiplyModulo(Plan* plan, const std::vector<int64_t>& a,
+                      const std::vector<int64_t>& b, int n,
+                      std::vector<uint32_t>* result) {
+    const int64_t mod = Plan::kModulus;
+    result->assign(n, 0);
+    buffer_.assign(n, 0);
+    for (int i = 0; i < (int)a.size(); ++i) {
+      (*result)[i] = (a[i] % mod + mod) % mod;
+    }
+    for (int i = 0; i < (int)b.size(); ++i) {
+      buffer_[i] = (b[i] % mod + mod) % mod;
+    }
+
+    plan->Convolve(result->data(), buffer_.data(), n);
+  }
+
+  Plan1 plan1_;
+  Plan2 plan2_;
+  Plan3 plan3_;
+  std::vector<uint32_t> r1_, r2_, r3_, buffer_;
+};
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @class Polynomial
@@ -28,29 +629,60 @@ class Polynomial {
    * @param other: The other polynomial.
    * @return The product of the two polynomials.
    */
-  Polynomial Multiply(const Polynomial& other) {
-    std::vector<std::complex<double>> a(coefficients_.begin(),
-                                        coefficients_.end());
-    std::vector<std::complex<double>> b(other.coefficients_.begin(),
-                                        other.coefficients_.end());
+  Polynomial Multiply(const Polynomial& other) const {
+    FftPlan plan;
+    std::vector<std::complex<double>> workspace;
+    return Multiply(other, &plan, &workspace);
+  }
 
-    int max_degree = a.size() + b.size() - 1;
+  /**
+   * @brief Multiplies this polynomial with other polynomial, reusing the given
+   * plan and workspace so that a sequence of multiplications allocates only
+   * when it meets a larger size. Both coefficient vectors are real, so they
+   * are packed into one complex vector a + i*b and only one forward and one
+   * inverse transform are needed. Time complexity: O(nlog(n)).
+   * @param other: The other polynomial.
+   * @param plan: The FFT plan.
+   * @param workspace: The buffer to transform in, resized as needed.
+   * @return The product of the two polynomials.
+   */
+  Polynomial Multiply(const Polynomial& other, FftPlan* plan,
+                      std::vector<std::complex<double>>* workspace) const {
+    int max_degree = coefficients_.size() + other.coefficients_.size() - 1;
     int min_power_2 = GetMinPowerOf2(max_degree);
-    a.resize(min_power_2);
-    b.resize(min_power_2);
+    if ((int)workspace->size() < min_power_2) {
+      workspace->resize(min_power_2);
+    }
 
-    std::vector<std::complex<double>> a_fft = FFT(a);
-    std::vector<std::complex<double>> b_fft = FFT(b);
-    std::vector<std::complex<double>> ab_fft(min_power_2);
+    std::complex<double>* z = workspace->data();
+    std::fill(z, z + min_power_2, 0);
+    for (int i = 0; i < (int)coefficients_.size(); ++i) {
+      z[i].real(coefficients_[i]);
+    }
+    for (int i = 0; i < (int)other.coefficients_.size(); ++i) {
+      z[i].imag(other.coefficients_[i]);
+    }
 
-    for (int i = 0; i < min_power_2; ++i) {
-      ab_fft[i] = a_fft[i] * b_fft[i];
+    plan->Transform(z, min_power_2, false);
+
+    // With Z = FFT(a + i*b), A[k] = (Z[k] + conj(Z[-k])) / 2 and
+    // B[k] = (Z[k] - conj(Z[-k])) / 2i, so
+    // A[k] * B[k] = (Z[k]^2 - conj(Z[-k])^2) / 4i. Each pair k, -k is
+    // computed together so the spectrum can be overwritten in place.
+    const std::complex<double> kQuarterOverI(0, -0.25);
+    for (int k = 0; k <= min_power_2 / 2; ++k) {
+      int j = (min_power_2 - k) & (min_power_2 - 1);
+      std::complex<double> zk = z[k];
+      std::complex<double> zj = z[j];
+      z[k] = (zk * zk - std::conj(zj * zj)) * kQuarterOverI;
+      z[j] = (zj * zj - std::conj(zk * zk)) * kQuarterOverI;
     }
 
-    std::vector<std::complex<double>> ab_ifft = IFFT(ab_fft);
+    plan->Transform(z, min_power_2, true);
+
     std::vector<double> new_coefficients(max_degree);
     for (int i = 0; i < max_degree; ++i) {
-      new_coefficients[i] = ab_ifft[i].real();
+      new_coefficients[i] = z[i].real();
     }
     return Polynomial(new_coefficients);
   }
@@ -62,85 +694,250 @@ class Polynomial {
   const std::vector<double>& coefficients() const { return coefficients_; }
 
  protected:
-  std::vector<std::complex<double>> FFT(
-      const std::vector<std::complex<double>>& coefficients) {
-    int n = coefficients.size();
-    if (n == 1) {
-      return coefficients;
+  static int GetMinPowerOf2(int n) {
+    int result = 1;
+    while (result < n) {
+      result = result << 1;
+    }
+
+    return result;
+  }
+
+ private:
+  std::vector<double> coefficients_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief The multiplication algorithms PolynomialMultiplier can use. kAuto
+ * chooses by operand sizes, the others force one algorithm.
+ */
+enum class MultiplyAlgorithm { kAuto, kSchoolbook, kKaratsuba, kFft };
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class PolynomialMultiplier
+ * @brief Implements polynomial multiplication which picks the cheapest
+ * algorithm for the operand sizes: the O(n*m) schoolbook loop for short
+ * operands, Karatsuba in O(n^1.58) for medium ones and the FFT for long
+ * ones. The choice depends on the shorter operand, and the crossover sizes
+ * can be measured on the running machine by Calibrate. The FFT plan and
+ * workspace are kept between calls.
+ */
+class PolynomialMultiplier {
+ public:
+  /**
+   * @brief Initializes a new instance of polynomial multiplier.
+   * @param algorithm: The algorithm to use, kAuto to choose by size.
+   */
+  explicit PolynomialMultiplier(
+      MultiplyAlgorithm algorithm = MultiplyAlgorithm::kAuto)
+      : algorithm_(algorithm) {}
+
+  /**
+   * @brief Initializes a new instance of polynomial multiplier which chooses
+   * by size with the given thresholds instead of the defaults.
+   * @param karatsuba_min: The shortest operand length for which Karatsuba is
+   * used.
+   * @param fft_min: The shortest operand length for which the FFT is used,
+   * Karatsuba is skipped if it is not above karatsuba_min.
+   */
+  PolynomialMultiplier(int karatsuba_min, int fft_min)
+      : algorithm_(MultiplyAlgorithm::kAuto),
+        karatsuba_min_(karatsuba_min),
+        fft_min_(fft_min) {}
+
+  /**
+   * @brief Multiplies two polynomials. Time complexity: O(n*m) for short
+   * operands, O(max(n,m)*min(n,m)^0.58) for medium and O(nlog(n)) for long.
+   * @param a: The first polynomial.
+   * @param b: The second polynomial.
+   * @return The product of the two polynomials.
+   */
+  Polynomial Multiply(const Polynomial& a, const Polynomial& b) {
+    return Multiply(a, b, Choose(a, b));
+  }
+
+  /**
+   * @brief Measures the three algorithms on random operands of doubling
+   * sizes, from twice kKaratsubaBase since Karatsuba is the schoolbook loop
+   * below that, and sets the thresholds to the first size at which the
+   * faster algorithm wins. If Karatsuba never beats the schoolbook loop
+   * before the FFT takes over, it is disabled. Takes a few milliseconds.
+   */
+  void Calibrate() {
+    std::vector<double> coefficients(kMaxCalibrationSize);
+    unsigned seed = 12345;
+    for (auto& c : coefficients) {
+      seed = seed * 1103515245 + 12345;
+      c = (int)(seed >> 16) % 2001 - 1000;
     }
 
-    std::vector<std::complex<double>> a0(n / 2), a1(n / 2);
-    for (int i = 0; i < n / 2; ++i) {
-      a0[i] = coefficients[i * 2];
-      a1[i] = coefficients[i * 2 + 1];
+    int karatsuba_min = -1;
+    int fft_min = kMaxCalibrationSize;
+    for (int size = 2 * kKaratsubaBase; size <= kMaxCalibrationSize;
+         size *= 2) {
+      Polynomial p(std::vector<double>(coefficients.begin(),
+                                       coefficients.begin() + size));
+      double schoolbook = Time(p, MultiplyAlgorithm::kSchoolbook);
+      double karatsuba = Time(p, MultiplyAlgorithm::kKaratsuba);
+      double fft = Time(p, MultiplyAlgorithm::kFft);
+
+      if (karatsuba_min == -1 && karatsuba < schoolbook) {
+        karatsuba_min = size;
+      }
+      if (fft < std::min(karatsuba, schoolbook)) {
+        fft_min = size;
+        break;
+      }
     }
 
-    std::vector<std::complex<double>> a0_fft = FFT(a0);
-    std::vector<std::complex<double>> a1_fft = FFT(a1);
+    // Karatsuba is skipped when karatsuba_min_ == fft_min_.
+    fft_min_ = fft_min;
+    karatsuba_min_ = karatsuba_min == -1 ? fft_min : karatsuba_min;
+  }
 
-    std::vector<std::complex<double>> result(n);
-    double step_angle = 2 * Polynomial::kPi / n;
-    std::complex<double> w_k(1), step(cos(step_angle), sin(step_angle));
+  /**
+   * @brief Gets the shortest operand length for which Karatsuba is used.
+   * @return The threshold.
+   */
+  int karatsuba_min() const { return karatsuba_min_; }
+
+  /**
+   * @brief Gets the shortest operand length for which the FFT is used.
+   * @return The threshold.
+   */
+  int fft_min() const { return fft_min_; }
+
+ private:
+  static const int kMaxCalibrationSize = 4096;
+  static const int kKaratsubaBase = 32;
+  static const int kCalibrationRuns = 7;
 
-    for (int k = 0; k < n / 2; ++k) {
-      result[k] = a0_fft[k] + w_k * a1_fft[k];
-      result[k + n / 2] = a0_fft[k] - w_k * a1_fft[k];
-      w_k *= step;
+  MultiplyAlgorithm Choose(const Polynomial& a, const Polynomial& b) const {
+    if (algorithm_ != MultiplyAlgorithm::kAuto) {
+      return algorithm_;
     }
 
-    return result;
+    int shorter = std::min(a.coefficients().size(), b.coefficients().size());
+    if (shorter < karatsuba_min_) {
+      return MultiplyAlgorithm::kSchoolbook;
+    } else if (shorter < fft_min_) {
+      return MultiplyAlgorithm::kKaratsuba;
+    }
+
+    return MultiplyAlgorithm::kFft;
   }
 
-  std::vector<std::complex<double>> IFFT(
-      const std::vector<std::complex<double>>& coefficients) {
-    int n = coefficients.size();
-    if (n == 1) {
-      return coefficients;
+  Polynomial Multiply(const Polynomial& a, const Polynomial& b,
+                      MultiplyAlgorithm algorithm) {
+    if (algorithm == MultiplyAlgorithm::kFft) {
+      return a.Multiply(b, &plan_, &workspace_);
     }
 
-    std::vector<std::complex<double>> a0(n / 2), a1(n / 2);
-    for (int i = 0; i < n / 2; ++i) {
-      a0[i] = coefficients[i * 2];
-      a1[i] = coefficients[i * 2 + 1];
+    const std::vector<double>& x = a.coefficients();
+    const std::vector<double>& y = b.coefficients();
+    std::vector<double> result(x.size() + y.size() - 1, 0);
+    if (algorithm == MultiplyAlgorithm::kSchoolbook) {
+      Schoolbook(x.data(), x.size(), y.data(), y.size(), result.data());
+      return Polynomial(result);
     }
 
-    std::vector<std::complex<double>> a0_fft = IFFT(a0);
-    std::vector<std::complex<double>> a1_fft = IFFT(a1);
+    // Karatsuba needs equal lengths, so the longer operand is cut into
+    // pieces of the shorter's length, the last one padded with zeros.
+    const std::vector<double>& longer = x.size() >= y.size() ? x : y;
+    const std::vector<double>& shorter = x.size() >= y.size() ? y : x;
+    int m = shorter.size();
+    std::vector<double> piece(m);
+    std::vector<double> product(2 * m - 1);
+    for (int begin = 0; begin < (int)longer.size(); begin += m) {
+      int length = std::min<int>(m, longer.size() - begin);
+      std::fill(piece.begin(), piece.end(), 0);
+      std::copy(longer.begin() + begin, longer.begin() + begin + length,
+                piece.begin());
+      std::fill(product.begin(), product.end(), 0);
+      Karatsuba(piece.data(), shorter.data(), m, product.data());
+      for (int i = 0; i < length + m - 1; ++i) {
+        result[begin + i] += product[i];
+      }
+    }
 
-    std::vector<std::complex<double>> result(n);
-    double step_angle = -2 * Polynomial::kPi / n;
-    std::complex<double> w_k(1), step(cos(step_angle), sin(step_angle));
+    return Polynomial(result);
+  }
 
-    for (int k = 0; k < n / 2; ++k) {
-      result[k] = (a0_fft[k] + w_k * a1_fft[k]);
-      // Since I use divide (each divide to 2 parts) and conquer, so here I
-      // divide 2. After all calling, the result is equal to dividing by n.
-      result[k] /= 2;
+  // Adds the product of a (length n) and b (length m) to result.
+  static void Schoolbook(const double* a, int n, const double* b, int m,
+                         double* result) {
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j < m; ++j) {
+        result[i + j] += a[i] * b[j];
+      }
+    }
+  }
 
-      result[k + n / 2] = (a0_fft[k] - w_k * a1_fft[k]);
-      // Since I use divide (each divide to 2 parts) and conquer, so here I
-      // divide 2. After all calling, the result is equal to dividing by n.
-      result[k + n / 2] /= 2;
+  // Adds the product of a and b, both of length n, to result.
+  static void Karatsuba(const double* a, const double* b, int n,
+                        double* result) {
+    if (n <= kKaratsubaBase) {
+      Schoolbook(a, n, b, n, result);
+      return;
+    }
 
-      w_k *= step;
+    // a = a0 + a1*x^k and b = b0 + b1*x^k, then
+    // a*b = z0 + (z1 - z0 - z2)*x^k + z2*x^2k with z1 = (a0+a1)*(b0+b1).
+    int k = n / 2;
+    int high = n - k;
+    std::vector<double> z0(2 * k - 1, 0), z2(2 * high - 1, 0);
+    std::vector<double> z1(2 * high - 1, 0);
+    Karatsuba(a, b, k, z0.data());
+    Karatsuba(a + k, b + k, high, z2.data());
+
+    std::vector<double> a_sum(a + k, a + n), b_sum(b + k, b + n);
+    for (int i = 0; i < k; ++i) {
+      a_sum[i] += a[i];
+      b_sum[i] += b[i];
     }
+    Karatsuba(a_sum.data(), b_sum.data(), high, z1.data());
 
-    return result;
+    for (int i = 0; i < (int)z0.size(); ++i) {
+      result[i] += z0[i];
+      z1[i] -= z0[i];
+    }
+    for (int i = 0; i < (int)z2.size(); ++i) {
+      result[i + 2 * k] += z2[i];
+      z1[i] -= z2[i];
+    }
+    for (int i = 0; i < (int)z1.size(); ++i) {
+      result[i + k] += z1[i];
+    }
   }
 
-  int GetMinPowerOf2(int n) {
-    int result = 1;
-    while (result < n) {
-      result = result << 1;
+  double Time(const Polynomial& p, MultiplyAlgorithm algorithm) {
+    // Small sizes are repeated so that every measurement is long enough for
+    // the clock; the best of several runs filters out noise.
+    int repeats = kMaxCalibrationSize / p.coefficients().size();
+    Multiply(p, p, algorithm);
+    double best = 1e18;
+    for (int i = 0; i < kCalibrationRuns; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      for (int j = 0; j < repeats; ++j) {
+        Multiply(p, p, algorithm);
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
     }
 
-    return result;
+    return best;
   }
 
- private:
-  const double kPi = std::acos(-1);
-
-  std::vector<double> coefficients_;
+  MultiplyAlgorithm algorithm_;
+  // Used until Calibrate is called. Measured by Calibrate on an x86-64
+  // machine, where Karatsuba never beat the schoolbook loop before the FFT.
+  int karatsuba_min_ = 128;
+  int fft_min_ = 128;
+  FftPlan plan_;
+  std::vector<std::complex<double>> workspace_;
 };
 
 }  // namespace zhoni04
@@ -152,6 +949,11 @@ int main(void) {
   int T;
   scanf("%d", &T);
 
+  // Shared by all test cases, so twiddles and buffers are computed once and
+  // the thresholds are measured once, in a few milliseconds.
+  PolynomialMultiplier multiplier;
+  multiplier.Calibrate();
+
   for (int i = 0; i < T; ++i) {
     int coefficient;
 
@@ -172,7 +974,7 @@ int main(void) {
     }
 
     Polynomial p_a(c_a), p_b(c_b);
-    Polynomial product = p_a.Multiply(p_b);
+    Polynomial product = multiplier.Multiply(p_a, p_b);
 
     int degree = product.coefficients().size() - 1;
 
@@ -185,5 +987,8 @@ int main(void) {
       int c = round(product.coefficients()[j]);
       printf("%d", c);
     }
+    printf("\n");
   }
+
+  return 0;
 }
@@ -0,0 +1,61 @@
+// Checks PolynomialMultiplier against the schoolbook product. Build and run:
+//   g++ -O2 -std=c++17 polymul2_test.cc -o polymul2_test && ./polymul2_test
+#include <cassert>
+
+#define main Polymul2Main
+#include "polymul2.cc"
+#undef main
+
+namespace {
+
+std::vector<double> RandomCoefficients(int size, unsigned* seed) {
+  std::vector<double> coefficients(size);
+  for (auto& c : coefficients) {
+    *seed = *seed * 1103515245 + 12345;
+    c = (int)(*seed >> 16) % 2001 - 1000;
+  }
+
+  return coefficients;
+}
+
+// Products of integers below 1000 in absolute value are exact in doubles for
+// these sizes, except for the FFT, whose result is rounded first.
+void CheckSame(PolynomialMultiplier* multiplier, bool rounded) {
+  const int kSizes[][2] = {{1, 1},    {1, 70},   {17, 17},  {40, 100},
+                           {100, 40}, {65, 65},  {33, 257}, {200, 200},
+                           {255, 3},  {300, 301}};
+  PolynomialMultiplier schoolbook(MultiplyAlgorithm::kSchoolbook);
+  unsigned seed = 1;
+  for (auto& size : kSizes) {
+    Polynomial a(RandomCoefficients(size[0], &seed));
+    Polynomial b(RandomCoefficients(size[1], &seed));
+    std::vector<double> expected = schoolbook.Multiply(a, b).coefficients();
+    std::vector<double> actual = multiplier->Multiply(a, b).coefficients();
+    assert(actual.size() == expected.size());
+    for (int i = 0; i < (int)actual.size(); ++i) {
+      assert((rounded ? std::round(actual[i]) : actual[i]) == expected[i]);
+    }
+  }
+}
+
+}  // namespace
+
+int main(void) {
+  // Every operand of 16 or more coefficients goes to Karatsuba by kAuto.
+  PolynomialMultiplier karatsuba_by_size(16, 1 << 30);
+  CheckSame(&karatsuba_by_size, false);
+
+  PolynomialMultiplier karatsuba(MultiplyAlgorithm::kKaratsuba);
+  CheckSame(&karatsuba, false);
+
+  PolynomialMultiplier fft(MultiplyAlgorithm::kFft);
+  CheckSame(&fft, true);
+
+  PolynomialMultiplier calibrated;
+  calibrated.Calibrate();
+  assert(calibrated.karatsuba_min() <= calibrated.fft_min());
+  CheckSame(&calibrated, true);
+
+  printf("All tests passed.\n");
+  return 0;
+}
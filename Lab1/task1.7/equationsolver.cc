@@ -1,15 +1,372 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <set>
+#include <thread>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define AAPS_SOLVER_X86 1
+#endif
+
 namespace aaps {
 namespace zhoni04 {
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class LuFactorization
+ * @brief Implements an LU factorization with partial pivoting of an n*m
+ * matrix, which can then solve Ax = b for many right-hand sides b. The matrix
+ * is stored flat in row-major order and factored as a blocked right-looking
+ * LU: a panel of kBlockSize columns is eliminated first, then the trailing
+ * columns of all rows are updated panel-wide in cache-sized tiles, four pivot
+ * rows at a time with an AVX2 kernel when the CPU has one. Only rows below
+ * each pivot are eliminated and rows are swapped through a permutation
+ * vector. A column without a usable pivot is skipped, so singular and
+ * rectangular matrices are factored too. For large matrices the trailing
+ * update of the rows below each panel can be split over several threads.
+ */
+class LuFactorization {
+ public:
+  /**
+   * @brief Factors the given matrix. Time complexity: O(n*m*min(n,m)).
+   * @param A: The coefficients, A[i * m + j] is the coefficient of x_j in
+   * equation i.
+   * @param n: The number of equations.
+   * @param m: The number of unknowns.
+   * @param threads: The number of threads to use for large trailing updates.
+   * The factors and the pivots chosen are identical for any thread count.
+   */
+  LuFactorization(const std::vector<double> &A, int n, int m, int threads = 1)
+      : n_(n), m_(m), threads_(std::max(threads, 1)), lu_(A), perm_(n) {
+    for (int i = 0; i < n; ++i) {
+      perm_[i] = i;
+    }
+
+    Factor();
+    FindWhere();
+  }
+
+  /**
+   * @brief Solves Ax = b with the factored A. Time complexity: O(n*m).
+   * @param b: A vector to represent the b of the linear equation.
+   * @param x: Used for store the solved unknown values, free unknowns are set
+   * to zero.
+   * @return 0 for no solution, 1 for exactly one solution, 2 for infinite
+   * number of solutions.
+   */
+  int Solve(const std::vector<double> &b, std::vector<double> *x) const {
+    std::vector<int> results = SolveBatch(b, 1, x);
+    return results[0];
+  }
+
+  /**
+   * @brief Solves AX = B with the factored A for k right-hand sides at once.
+   * All right-hand sides are carried through one sweep over the factors, so
+   * the factors are read once instead of k times. Time complexity:
+   * O(n*m*k).
+   * @param B: The right-hand sides, n*k in row-major order; column j is the
+   * j-th b.
+   * @param k: The number of right-hand sides.
+   * @param X: Used for store the solutions, m*k in row-major order.
+   * @return The 0/1/2 classification of each right-hand side.
+   */
+  std::vector<int> SolveBatch(const std::vector<double> &B, int k,
+                              std::vector<double> *X) const {
+    int rank = pivot_cols_.size();
+
+    // Forward substitution with the unit lower factor, row by row in pivot
+    // order. Row i was eliminated by pivots 0 ~ min(i, rank)-1.
+    std::vector<double> y(n_ * k);
+    for (int i = 0; i < n_; ++i) {
+      double *yi = y.data() + i * k;
+      std::copy(B.begin() + perm_[i] * k, B.begin() + (perm_[i] + 1) * k, yi);
+      for (int s = 0; s < std::min(i, rank); ++s) {
+        double ratio = at(i, pivot_cols_[s]);
+        const double *ys = y.data() + s * k;
+        for (int c = 0; c < k; ++c) {
+          yi[c] -= ys[c] * ratio;
+        }
+      }
+    }
+
+    // Rows without a pivot have all coefficients eliminated, so only their b
+    // remains.
+    std::vector<int> results(k, rank < m_ ? 2 : 1);
+    for (int i = rank; i < n_; ++i) {
+      for (int c = 0; c < k; ++c) {
+        if (std::fabs(y[i * k + c]) > kEpsilon) {
+          results[c] = 0;
+        }
+      }
+    }
+
+    // Back substitution with every free unknown set to zero.
+    X->assign(m_ * k, 0);
+    for (int t = rank - 1; t >= 0; --t) {
+      double *xt = X->data() + pivot_cols_[t] * k;
+      std::copy(y.begin() + t * k, y.begin() + (t + 1) * k, xt);
+      for (int s = t + 1; s < rank; ++s) {
+        double coefficient = at(t, pivot_cols_[s]);
+        const double *xs = X->data() + pivot_cols_[s] * k;
+        for (int c = 0; c < k; ++c) {
+          xt[c] -= xs[c] * coefficient;
+        }
+      }
+
+      double pivot = at(t, pivot_cols_[t]);
+      for (int c = 0; c < k; ++c) {
+        xt[c] /= pivot;
+      }
+    }
+
+    return results;
+  }
+
+  /**
+   * @brief Gets the rank of the factored matrix.
+   * @return The rank.
+   */
+  int rank() const { return pivot_cols_.size(); }
+
+  /**
+   * @brief Gets, for each unknown, the row index of its pivot in elimination
+   * order, or -1 if the unknown is not uniquely determined (a free unknown
+   * or one which depends on a free unknown).
+   * @return The where vector.
+   */
+  const std::vector<int> &where() const { return where_; }
+
+  /**
+   * @brief Gets the free unknowns, those without a pivot.
+   * @return The indices of free unknowns in increasing order.
+   */
+  std::vector<int> free_variables() const {
+    std::vector<int> result;
+    std::vector<bool> is_pivot(m_, false);
+    for (int c : pivot_cols_) {
+      is_pivot[c] = true;
+    }
+    for (int j = 0; j < m_; ++j) {
+      if (!is_pivot[j]) {
+        result.push_back(j);
+      }
+    }
+
+    return result;
+  }
+
+ private:
+  static constexpr double kEpsilon = 1e-9;
+  static const int kBlockSize = 32;
+  static const int kTileSize = 256;
+  // Trailing updates smaller than this many elements stay on one thread.
+  static const int kMinParallelWork = 1 << 18;
+
+  // Computes r[j] -= u0[j] * l0 + u1[j] * l1 + u2[j] * l2 + u3[j] * l3 for
+  // j in begin ~ end-1.
+  using UpdateFunc = void (*)(double *r, const double *u0, const double *u1,
+                              const double *u2, const double *u3, double l0,
+                              double l1, double l2, double l3, int begin,
+                              int end);
+
+  static void UpdateScalar(double *r, const double *u0, const double *u1,
+                           const double *u2, const double *u3, double l0,
+                           double l1, double l2, double l3, int begin,
+                           int end) {
+    for (int j = begin; j < end; ++j) {
+      r[j] -= u0[j] * l0 + u1[j] * l1 + u2[j] * l2 + u3[j] * l3;
+    }
+  }
+
+#ifdef AAPS_SOLVER_X86
+  __attribute__((target("avx2,fma"))) static void UpdateAvx2(
+      double *r, const double *u0, const double *u1, const double *u2,
+      const double *u3, double l0, double l1, double l2, double l3, int begin,
+      int end) {
+    __m256d v0 = _mm256_set1_pd(l0), v1 = _mm256_set1_pd(l1);
+    __m256d v2 = _mm256_set1_pd(l2), v3 = _mm256_set1_pd(l3);
+    int j = begin;
+    for (; j + 4 <= end; j += 4) {
+      __m256d sum = _mm256_mul_pd(_mm256_loadu_pd(u0 + j), v0);
+      sum = _mm256_fmadd_pd(_mm256_loadu_pd(u1 + j), v1, sum);
+      sum = _mm256_fmadd_pd(_mm256_loadu_pd(u2 + j), v2, sum);
+      sum = _mm256_fmadd_pd(_mm256_loadu_pd(u3 + j), v3, sum);
+      _mm256_storeu_pd(r + j, _mm256_sub_pd(_mm256_loadu_pd(r + j), sum));
+    }
+    UpdateScalar(r, u0, u1, u2, u3, l0, l1, l2, l3, j, end);
+  }
+#endif
+
+  static UpdateFunc SelectUpdate() {
+#ifdef AAPS_SOLVER_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return UpdateAvx2;
+    }
+#endif
+    return UpdateScalar;
+  }
+
+  double at(int row, int col) const { return lu_[perm_[row] * m_ + col]; }
+
+  // Eliminates below the pivots, storing the multiplier of each eliminated
+  // entry in its place. Rows perm_[0 ~ rank-1] are the pivot rows in order,
+  // and pivot_cols_ holds the pivot column of each of them.
+  void Factor() {
+    int n = n_;
+    int m = m_;
+    double *data = lu_.data();
+    UpdateFunc update = SelectUpdate();
+
+    int row = 0;
+    for (int panel_begin = 0; panel_begin < m && row < n;
+         panel_begin += kBlockSize) {
+      int panel_end = std::min(panel_begin + kBlockSize, m);
+      int panel_row = row;
+
+      // Unblocked elimination restricted to the panel columns.
+      for (int col = panel_begin; col < panel_end && row < n; ++col) {
+        int pivot = row;
+        for (int i = row; i < n; ++i) {
+          if (std::fabs(data[perm_[i] * m + col]) >
+              std::fabs(data[perm_[pivot] * m + col])) {
+            pivot = i;
+          }
+        }
+
+        // For current column, can not find a row, which coefficient is not
+        // zero.
+        if (std::fabs(data[perm_[pivot] * m + col]) < kEpsilon) {
+          continue;
+        }
+
+        std::swap(perm_[pivot], perm_[row]);
+        const double *pivot_row = data + perm_[row] * m;
+        for (int i = row + 1; i < n; ++i) {
+          double *r = data + perm_[i] * m;
+          double ratio = r[col] / pivot_row[col];
+          r[col] = ratio;
+          for (int j = col + 1; j < panel_end; ++j) {
+            r[j] -= pivot_row[j] * ratio;
+          }
+        }
+
+        pivot_cols_.push_back(col);
+        ++row;
+      }
+
+      // Trailing update of columns panel_end ~ m-1: first the pivot rows of
+      // this panel in order, which is the triangular solve, then every row
+      // below them. Those rows only read the pivot rows, so they are split
+      // over threads. Each row is updated by the same operations whatever the
+      // split, so later pivot searches see the same values.
+      UpdateTrailing(panel_row, row, panel_row + 1, row, panel_end, update);
+
+      int rows = n - row;
+      int threads = 1;
+      if ((long long)rows * (m - panel_end) >= kMinParallelWork) {
+        threads = std::min(threads_, rows);
+      }
+      int chunk = (rows + threads - 1) / threads;
+      ParallelFor(threads, [&](int t) {
+        UpdateTrailing(panel_row, row, row + t * chunk,
+                       std::min(n, row + (t + 1) * chunk), panel_end, update);
+      });
+    }
+  }
+
+  // Applies the pivot rows panel_row ~ row-1 to columns col_begin ~ m-1 of
+  // rows begin ~ end-1, each row using the pivots above it.
+  void UpdateTrailing(int panel_row, int row, int begin, int end,
+                      int col_begin, UpdateFunc update) {
+    int m = m_;
+    double *data = lu_.data();
+    for (int tile = col_begin; tile < m; tile += kTileSize) {
+      int tile_end = std::min(tile + kTileSize, m);
+      for (int i = begin; i < end; ++i) {
+        double *r = data + perm_[i] * m;
+        int pivots = std::min(i, row) - panel_row;
+        int t = 0;
+        // Four pivot rows at a time, so each element of r is loaded and
+        // stored once per four updates.
+        for (; t + 4 <= pivots; t += 4) {
+          const double *u0 = data + perm_[panel_row + t] * m;
+          const double *u1 = data + perm_[panel_row + t + 1] * m;
+          const double *u2 = data + perm_[panel_row + t + 2] * m;
+          const double *u3 = data + perm_[panel_row + t + 3] * m;
+          double l0 = r[pivot_cols_[panel_row + t]];
+          double l1 = r[pivot_cols_[panel_row + t + 1]];
+          double l2 = r[pivot_cols_[panel_row + t + 2]];
+          double l3 = r[pivot_cols_[panel_row + t + 3]];
+          update(r, u0, u1, u2, u3, l0, l1, l2, l3, tile, tile_end);
+        }
+        for (; t < pivots; ++t) {
+          const double *u = data + perm_[panel_row + t] * m;
+          double ratio = r[pivot_cols_[panel_row + t]];
+          for (int j = tile; j < tile_end; ++j) {
+            r[j] -= u[j] * ratio;
+          }
+        }
+      }
+    }
+  }
+
+  // Runs func(0) ~ func(threads-1), one per thread, and waits for all.
+  template <typename Func>
+  static void ParallelFor(int threads, const Func &func) {
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t) {
+      workers.emplace_back(func, t);
+    }
+    func(0);
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  // A pivot unknown is independent only if its row of the reduced row echelon
+  // form has no coefficient left on any free unknown. That row's entry on
+  // free column f is pivot_t * y_t, where U * y = U[:, f] over the pivot
+  // columns, so one back substitution per free column finds them.
+  void FindWhere() {
+    int rank = pivot_cols_.size();
+    where_.assign(m_, -1);
+    for (int t = 0; t < rank; ++t) {
+      where_[pivot_cols_[t]] = t;
+    }
+
+    std::vector<double> y(rank);
+    for (int f : free_variables()) {
+      for (int t = rank - 1; t >= 0; --t) {
+        double sum = pivot_cols_[t] < f ? at(t, f) : 0;
+        for (int s = t + 1; s < rank; ++s) {
+          sum -= at(t, pivot_cols_[s]) * y[s];
+        }
+        y[t] = sum / at(t, pivot_cols_[t]);
+
+        if (std::fabs(y[t] * at(t, pivot_cols_[t])) > kEpsilon) {
+          where_[pivot_cols_[t]] = -1;
+        }
+      }
+    }
+  }
+
+  int n_;
+  int m_;
+  int threads_;
+  std::vector<double> lu_;
+  std::vector<int> perm_;
+  std::vector<int> pivot_cols_;
+  std::vector<int> where_;
+};
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @class EquationSolver
- * @brief Implements an equation solver based on Gauss-Jordan elimination. The
- * main idea comes from here:
+ * @brief Implements an equation solver based on Gaussian elimination with
+ * partial pivoting, done by LuFactorization. The main idea comes from here:
  * https://cp-algorithms.com/linear_algebra/linear-system-gauss.html
  */
 class EquationSolver {
@@ -23,107 +380,846 @@ class EquationSolver {
    * @param x: Used for store the solved unknown values.
    * @param where: Used for store the row index of coefficient for each solved
    * value.
+   * @param threads: The number of threads to use for large systems.
    * @return 0 for no solution, 1 for exactly one solution, 2 for infinite
    * number of solutions.
    */
   static int Solve(const std::vector<std::vector<double>> &A,
                    const std::vector<double> &b, std::vector<double> *x,
-                   std::vector<int> *where = nullptr) {
-    static double epsilon = 1e-9;
-
+                   std::vector<int> *where = nullptr, int threads = 1) {
     int n = A.size();
     int m = A[0].size();
 
-    std::vector<std::vector<double>> local_A(A);
-    std::vector<double> local_b(b);
+    std::vector<double> flat_A(n * m);
+    for (int i = 0; i < n; ++i) {
+      std::copy(A[i].begin(), A[i].end(), flat_A.begin() + i * m);
+    }
 
-    std::vector<int> local_where(m, -1);
+    return Solve(flat_A, n, m, b, x, where, threads);
+  }
 
-    int row = 0, col = 0;
-    while (row < n && col < m) {
-      // Find pivot row.
-      int pivot = row;
-      for (int i = row; i < n; ++i) {
-        if (std::fabs(local_A[i][col]) > std::fabs(local_A[pivot][col])) {
-          pivot = i;
+  /**
+   * @brief Solves a linear algebraic equation like Ax = b, where A is stored
+   * contiguously in row-major order. Time complexity: O(n^3).
+   * @param A: The coefficients, A[i * m + j] is the coefficient of x_j in
+   * equation i.
+   * @param n: The number of equations.
+   * @param m: The number of unknowns.
+   * @param b: A vector to represent the b of the linear equation.
+   * @param x: Used for store the solved unknown values.
+   * @param where: Used for store the row index of coefficient for each solved
+   * value, in elimination order, -1 for a value which is not uniquely
+   * determined.
+   * @param threads: The number of threads to use for large systems, the
+   * result does not depend on it.
+   * @return 0 for no solution, 1 for exactly one solution, 2 for infinite
+   * number of solutions.
+   */
+  static int Solve(const std::vector<double> &A, int n, int m,
+                   const std::vector<double> &b, std::vector<double> *x,
+                   std::vector<int> *where = nullptr, int threads = 1) {
+    LuFactorization lu(A, n, m, threads);
+
+    std::vector<double> local_x;
+    int solution_num = lu.Solve(b, &local_x);
+
+    if (x != nullptr) {
+      *x = local_x;
+    }
+
+    if (where != nullptr) {
+      *where = lu.where();
+    }
+
+    return solution_num;
+  }
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class CsrMatrix
+ * @brief Implements a sparse matrix in compressed sparse row form: the
+ * non-zero entries of row i are col_indices()[row_begin()[i] ~
+ * row_begin()[i+1]-1] and the matching values(). Rows are appended one at a
+ * time, so a matrix can be read without ever storing its zeros.
+ */
+class CsrMatrix {
+ public:
+  /**
+   * @brief Initializes a new instance of an empty matrix, rows are added by
+   * Add and EndRow.
+   * @param n: The number of rows.
+   * @param m: The number of columns.
+   */
+  CsrMatrix(int n, int m) : n_(n), m_(m), row_begin_(1, 0) {}
+
+  /**
+   * @brief Builds a sparse matrix from a dense row-major one, dropping zeros.
+   * Time complexity: O(n*m).
+   * @param A: The dense matrix, A[i * m + j] is the entry at row i, column j.
+   * @param n: The number of rows.
+   * @param m: The number of columns.
+   * @return The sparse matrix.
+   */
+  static CsrMatrix FromDense(const std::vector<double> &A, int n, int m) {
+    CsrMatrix matrix(n, m);
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j < m; ++j) {
+        if (A[i * m + j] != 0) {
+          matrix.Add(j, A[i * m + j]);
+        }
+      }
+      matrix.EndRow();
+    }
+
+    return matrix;
+  }
+
+  /**
+   * @brief Appends an entry to the current row. Time complexity: O(1).
+   * @param col: The column of the entry, not already in the current row.
+   * @param value: The value of the entry.
+   */
+  void Add(int col, double value) {
+    col_indices_.push_back(col);
+    values_.push_back(value);
+  }
+
+  /**
+   * @brief Finishes the current row and starts the next one. Time
+   * complexity: O(1).
+   */
+  void EndRow() { row_begin_.push_back(col_indices_.size()); }
+
+  /**
+   * @brief Computes y = Ax. Time complexity: O(nnz).
+   * @param x: The vector to multiply, of size m.
+   * @param y: Used for store the product, of size n.
+   */
+  void Multiply(const std::vector<double> &x, std::vector<double> *y) const {
+    y->assign(n_, 0);
+    for (int i = 0; i < n_; ++i) {
+      double sum = 0;
+      for (int e = row_begin_[i]; e < row_begin_[i + 1]; ++e) {
+        sum += values_[e] * x[col_indices_[e]];
+      }
+      (*y)[i] = sum;
+    }
+  }
+
+  /**
+   * @brief Expands the matrix to dense row-major form. Time complexity:
+   * O(n*m).
+   * @return The dense matrix.
+   */
+  std::vector<double> ToDense() const {
+    std::vector<double> A(n_ * m_, 0);
+    for (int i = 0; i < n_; ++i) {
+      for (int e = row_begin_[i]; e < row_begin_[i + 1]; ++e) {
+        A[i * m_ + col_indices_[e]] = values_[e];
+      }
+    }
+
+    return A;
+  }
+
+  int rows() const { return n_; }
+  int cols() const { return m_; }
+  int nnz() const { return values_.size(); }
+  const std::vector<int> &row_begin() const { return row_begin_; }
+  const std::vector<int> &col_indices() const { return col_indices_; }
+  const std::vector<double> &values() const { return values_; }
+
+ private:
+  int n_;
+  int m_;
+  std::vector<int> row_begin_;
+  std::vector<int> col_indices_;
+  std::vector<double> values_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class SparseLuFactorization
+ * @brief Implements a right-looking sparse LU factorization. Rows are kept
+ * as lists of their non-zero entries and each step pivots on a column with
+ * the fewest non-zeros left, in the sparsest row whose entry is at least
+ * kThreshold times the largest one of the column. This Markowitz-style
+ * choice keeps the fill low while bounding the growth of the entries. The
+ * classification and where vector follow LuFactorization, with where
+ * counting pivot steps.
+ */
+class SparseLuFactorization {
+ public:
+  /**
+   * @brief Factors the given matrix. Time complexity: O(nnz of the factors
+   * times the average row length), plus O(log(m)) per column count change.
+   * @param A: The coefficients.
+   */
+  explicit SparseLuFactorization(const CsrMatrix &A)
+      : n_(A.rows()), m_(A.cols()), l_begin_(1, 0), u_begin_(1, 0) {
+    Factor(A);
+    FindWhere();
+  }
+
+  /**
+   * @brief Solves Ax = b with the factored A. Time complexity: O(nnz of the
+   * factors).
+   * @param b: A vector to represent the b of the linear equation.
+   * @param x: Used for store the solved unknown values, free unknowns are set
+   * to zero.
+   * @return 0 for no solution, 1 for exactly one solution, 2 for infinite
+   * number of solutions.
+   */
+  int Solve(const std::vector<double> &b, std::vector<double> *x) const {
+    int rank = pivot_cols_.size();
+
+    std::vector<double> y(b);
+    for (int k = 0; k < rank; ++k) {
+      double pivot_y = y[pivot_rows_[k]];
+      for (int e = l_begin_[k]; e < l_begin_[k + 1]; ++e) {
+        y[l_entries_[e].index] -= l_entries_[e].value * pivot_y;
+      }
+    }
+
+    // Rows without a pivot have all coefficients eliminated, so only their b
+    // remains.
+    int solution_num = rank < m_ ? 2 : 1;
+    for (int i : remaining_rows_) {
+      if (std::fabs(y[i]) > kEpsilon) {
+        solution_num = 0;
+      }
+    }
+
+    x->assign(m_, 0);
+    for (int k = rank - 1; k >= 0; --k) {
+      (*x)[pivot_cols_[k]] = BackSubstitute(k, y[pivot_rows_[k]], *x);
+    }
+
+    return solution_num;
+  }
+
+  /**
+   * @brief Gets the rank of the factored matrix.
+   * @return The rank.
+   */
+  int rank() const { return pivot_cols_.size(); }
+
+  /**
+   * @brief Gets the number of stored entries of both factors, a measure of
+   * the fill.
+   * @return The number of entries.
+   */
+  int nnz() const { return l_entries_.size() + u_entries_.size(); }
+
+  /**
+   * @brief Gets, for each unknown, the pivot step which solved it, or -1 if
+   * the unknown is not uniquely determined.
+   * @return The where vector.
+   */
+  const std::vector<int> &where() const { return where_; }
+
+ private:
+  struct Entry {
+    int index;
+    double value;
+  };
+
+  static constexpr double kEpsilon = 1e-9;
+  static constexpr double kThreshold = 0.1;
+
+  void Factor(const CsrMatrix &A) {
+    std::vector<std::vector<Entry>> rows(n_);
+    std::vector<std::vector<int>> col_rows(m_);
+    std::vector<int> col_count(m_, 0);
+    for (int i = 0; i < n_; ++i) {
+      for (int e = A.row_begin()[i]; e < A.row_begin()[i + 1]; ++e) {
+        int col = A.col_indices()[e];
+        rows[i].push_back({col, A.values()[e]});
+        col_rows[col].push_back(i);
+        ++col_count[col];
+      }
+    }
+
+    // Active columns ordered by their number of non-zeros in active rows.
+    std::set<std::pair<int, int>> queue;
+    for (int j = 0; j < m_; ++j) {
+      queue.insert({col_count[j], j});
+    }
+
+    auto change_count = [&](int col, int delta) {
+      queue.erase({col_count[col], col});
+      col_count[col] += delta;
+      queue.insert({col_count[col], col});
+    };
+
+    std::vector<bool> row_active(n_, true);
+    std::vector<bool> col_active(m_, true);
+    std::vector<int> position(m_, -1);
+    while (!queue.empty()) {
+      int col = queue.begin()->second;
+      queue.erase(queue.begin());
+      col_active[col] = false;
+
+      // A pivot row leaves every column list lazily, skip those.
+      std::vector<Entry> column;
+      double max_value = 0;
+      for (int i : col_rows[col]) {
+        if (!row_active[i]) {
+          continue;
+        }
+
+        for (const Entry &entry : rows[i]) {
+          if (entry.index == col) {
+            column.push_back({i, entry.value});
+            max_value = std::max(max_value, std::fabs(entry.value));
+            break;
+          }
         }
       }
+      std::vector<int>().swap(col_rows[col]);
 
-      // For current column, can not find a row, which coefficient is not zero.
-      if (std::fabs(local_A[pivot][col]) < epsilon) {
-        ++col;
+      // For current column, can not find a row, which coefficient is not
+      // zero.
+      if (max_value < kEpsilon) {
         continue;
       }
 
-      for (int j = col; j < m; ++j) {
-        std::swap(local_A[pivot][j], local_A[row][j]);
+      int pivot_row = -1;
+      double pivot = 0;
+      for (const Entry &entry : column) {
+        if (std::fabs(entry.value) >= kThreshold * max_value &&
+            (pivot_row == -1 ||
+             rows[entry.index].size() < rows[pivot_row].size())) {
+          pivot_row = entry.index;
+          pivot = entry.value;
+        }
       }
-      std::swap(local_b[pivot], local_b[row]);
-      local_where[col] = row;
 
-      for (int i = 0; i < n; ++i) {
-        if (i == row) {
+      row_active[pivot_row] = false;
+      const std::vector<Entry> &u = rows[pivot_row];
+      for (const Entry &entry : u) {
+        if (col_active[entry.index]) {
+          change_count(entry.index, -1);
+        }
+      }
+
+      for (const Entry &entry : column) {
+        int i = entry.index;
+        if (i == pivot_row) {
           continue;
         }
 
-        double ratio = local_A[i][col] / local_A[row][col];
-        for (int j = col; j < m; ++j) {
-          local_A[i][j] -= local_A[row][j] * ratio;
+        double ratio = entry.value / pivot;
+        l_entries_.push_back({i, ratio});
+
+        // Scatter row i so each entry of the pivot row finds its match in
+        // O(1), then append the fill.
+        std::vector<Entry> &r = rows[i];
+        for (int e = 0; e < (int)r.size(); ++e) {
+          position[r[e].index] = e;
+        }
+        for (const Entry &v : u) {
+          if (v.index == col) {
+            continue;
+          }
+
+          if (position[v.index] != -1) {
+            r[position[v.index]].value -= v.value * ratio;
+          } else {
+            r.push_back({v.index, -v.value * ratio});
+            if (col_active[v.index]) {
+              col_rows[v.index].push_back(i);
+              change_count(v.index, 1);
+            }
+          }
         }
-        local_b[i] -= local_b[row] * ratio;
+
+        int at_col = position[col];
+        for (const Entry &v : r) {
+          position[v.index] = -1;
+        }
+        r[at_col] = r.back();
+        r.pop_back();
       }
 
-      ++row;
-      ++col;
+      pivot_rows_.push_back(pivot_row);
+      pivot_cols_.push_back(col);
+      pivots_.push_back(pivot);
+      l_begin_.push_back(l_entries_.size());
+      for (const Entry &entry : u) {
+        if (entry.index != col) {
+          u_entries_.push_back(entry);
+        }
+      }
+      u_begin_.push_back(u_entries_.size());
+      std::vector<Entry>().swap(rows[pivot_row]);
     }
 
-    std::vector<double> local_x(m, 0);
-    for (int j = 0; j < m; ++j) {
-      if (local_where[j] == -1) {
+    for (int i = 0; i < n_; ++i) {
+      if (row_active[i]) {
+        remaining_rows_.push_back(i);
+      }
+    }
+  }
+
+  // Returns (rhs - sum of the off-pivot entries of U row k times x) divided
+  // by the pivot, the value of the unknown solved at step k.
+  double BackSubstitute(int k, double rhs, const std::vector<double> &x) const {
+    double sum = rhs;
+    for (int e = u_begin_[k]; e < u_begin_[k + 1]; ++e) {
+      sum -= u_entries_[e].value * x[u_entries_[e].index];
+    }
+
+    return sum / pivots_[k];
+  }
+
+  // Same test as LuFactorization::FindWhere: an unknown solved at step k
+  // depends on the free unknown f if setting x_f = 1 and the other free
+  // unknowns to zero moves it.
+  void FindWhere() {
+    int rank = pivot_cols_.size();
+    where_.assign(m_, -1);
+    std::vector<bool> is_pivot(m_, false);
+    for (int k = 0; k < rank; ++k) {
+      where_[pivot_cols_[k]] = k;
+      is_pivot[pivot_cols_[k]] = true;
+    }
+
+    std::vector<double> x(m_, 0);
+    for (int f = 0; f < m_ && rank > 0; ++f) {
+      if (is_pivot[f]) {
         continue;
       }
 
-      local_x[j] = local_b[local_where[j]] / local_A[local_where[j]][j];
+      std::fill(x.begin(), x.end(), 0);
+      x[f] = 1;
+      for (int k = rank - 1; k >= 0; --k) {
+        x[pivot_cols_[k]] = BackSubstitute(k, 0, x);
+        if (std::fabs(x[pivot_cols_[k]] * pivots_[k]) > kEpsilon) {
+          where_[pivot_cols_[k]] = -1;
+        }
+      }
+    }
+  }
+
+  int n_;
+  int m_;
+  std::vector<int> pivot_rows_;
+  std::vector<int> pivot_cols_;
+  std::vector<double> pivots_;
+  // Step k eliminated rows l_entries_[l_begin_[k] ~ l_begin_[k+1]-1] with
+  // the stored ratios; its pivot row minus the pivot is the matching range
+  // of u_entries_.
+  std::vector<int> l_begin_;
+  std::vector<Entry> l_entries_;
+  std::vector<int> u_begin_;
+  std::vector<Entry> u_entries_;
+  std::vector<int> remaining_rows_;
+  std::vector<int> where_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class SparseEquationSolver
+ * @brief Implements equation solvers for sparse systems, whose time and
+ * memory grow with the number of non-zeros instead of n*m: a direct solver
+ * done by SparseLuFactorization, and an iterative BiCGSTAB solver with a
+ * Jacobi preconditioner for large square systems where only x is needed.
+ */
+class SparseEquationSolver {
+ public:
+  /**
+   * @brief Checks whether a matrix is sparse enough for the sparse direct
+   * solver to beat the dense one.
+   * @param A: The coefficients.
+   * @return True if A has at least kMinSize rows and at most one entry in
+   * kMinSparsity non-zero.
+   */
+  static bool Suits(const CsrMatrix &A) {
+    return A.rows() >= kMinSize &&
+           (long long)A.nnz() * kMinSparsity <= (long long)A.rows() * A.cols();
+  }
+
+  /**
+   * @brief Solves a linear algebraic equation like Ax = b with a sparse
+   * direct factorization.
+   * @param A: The coefficients.
+   * @param b: A vector to represent the b of the linear equation.
+   * @param x: Used for store the solved unknown values.
+   * @param where: Used for store the pivot step of each solved value, -1 for
+   * a value which is not uniquely determined.
+   * @return 0 for no solution, 1 for exactly one solution, 2 for infinite
+   * number of solutions.
+   */
+  static int Solve(const CsrMatrix &A, const std::vector<double> &b,
+                   std::vector<double> *x, std::vector<int> *where = nullptr) {
+    SparseLuFactorization lu(A);
+
+    std::vector<double> local_x;
+    int solution_num = lu.Solve(b, &local_x);
+
+    if (x != nullptr) {
+      *x = local_x;
+    }
+
+    if (where != nullptr) {
+      *where = lu.where();
+    }
+
+    return solution_num;
+  }
+
+  /**
+   * @brief Solves a square system Ax = b iteratively by BiCGSTAB with a
+   * Jacobi (diagonal) preconditioner. Each iteration costs two products with
+   * A, so the time complexity is O(nnz) per iteration.
+   * @param A: The coefficients, a square matrix.
+   * @param b: A vector to represent the b of the linear equation.
+   * @param x: Used for store the solution, its content on entry is used as
+   * the initial guess if it has the right size.
+   * @param tolerance: The relative residual |b - Ax| / |b| to reach.
+   * @param max_iterations: The maximal number of iterations.
+   * @return The number of iterations used, or -1 if the tolerance was not
+   * reached or the method broke down.
+   */
+  static int SolveIterative(const CsrMatrix &A, const std::vector<double> &b,
+                            std::vector<double> *x, double tolerance = 1e-10,
+                            int max_iterations = 1000) {
+    int n = A.rows();
+    if ((int)x->size() != n) {
+      x->assign(n, 0);
+    }
+
+    // Inverse diagonal, rows without a diagonal entry are left unscaled.
+    std::vector<double> inverse_diagonal(n, 1);
+    for (int i = 0; i < n; ++i) {
+      for (int e = A.row_begin()[i]; e < A.row_begin()[i + 1]; ++e) {
+        if (A.col_indices()[e] == i && A.values()[e] != 0) {
+          inverse_diagonal[i] = 1 / A.values()[e];
+        }
+      }
+    }
+
+    double b_norm = std::sqrt(Dot(b, b));
+    if (b_norm == 0) {
+      x->assign(n, 0);
+      return 0;
+    }
+
+    std::vector<double> r(n), r_hat(n), p(n, 0), v(n, 0), s(n), t(n), y(n),
+        z(n);
+    A.Multiply(*x, &r);
+    for (int i = 0; i < n; ++i) {
+      r[i] = b[i] - r[i];
     }
+    r_hat = r;
 
-    int solution_num = 1;
+    double rho = 1, alpha = 1, omega = 1;
+    for (int iteration = 1; iteration <= max_iterations; ++iteration) {
+      double rho_next = Dot(r_hat, r);
+      if (rho_next == 0 || omega == 0) {
+        return -1;
+      }
+
+      double beta = (rho_next / rho) * (alpha / omega);
+      for (int i = 0; i < n; ++i) {
+        p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        y[i] = p[i] * inverse_diagonal[i];
+      }
+      A.Multiply(y, &v);
+      alpha = rho_next / Dot(r_hat, v);
+
+      for (int i = 0; i < n; ++i) {
+        s[i] = r[i] - alpha * v[i];
+      }
+      if (std::sqrt(Dot(s, s)) <= tolerance * b_norm) {
+        for (int i = 0; i < n; ++i) {
+          (*x)[i] += alpha * y[i];
+        }
+        return iteration;
+      }
 
+      for (int i = 0; i < n; ++i) {
+        z[i] = s[i] * inverse_diagonal[i];
+      }
+      A.Multiply(z, &t);
+      omega = Dot(t, s) / Dot(t, t);
+
+      for (int i = 0; i < n; ++i) {
+        (*x)[i] += alpha * y[i] + omega * z[i];
+        r[i] = s[i] - omega * t[i];
+      }
+      if (std::sqrt(Dot(r, r)) <= tolerance * b_norm) {
+        return iteration;
+      }
+
+      rho = rho_next;
+    }
+
+    return -1;
+  }
+
+ private:
+  static const int kMinSize = 64;
+  static const int kMinSparsity = 20;
+
+  static double Dot(const std::vector<double> &a,
+                    const std::vector<double> &b) {
+    double sum = 0;
+    for (int i = 0; i < (int)a.size(); ++i) {
+      sum += a[i] * b[i];
+    }
+
+    return sum;
+  }
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class BareissEquationSolver
+ * @brief Implements an exact equation solver for integer systems based on
+ * fraction-free Gauss-Jordan elimination (Bareiss). Every intermediate entry
+ * is a minor of the augmented matrix and every division is exact, so no
+ * epsilon is needed and the classification is always right. Entries are
+ * 128-bit integers; if a minor does not fit, kOverflow is returned.
+ */
+class BareissEquationSolver {
+ public:
+  static const int kOverflow = -1;
+
+  /**
+   * @brief Solves a linear algebraic equation like Ax = b with integer
+   * coefficients exactly. Time complexity: O(n*m*min(n,m)).
+   * @param A: The coefficients, A[i * m + j] is the coefficient of x_j in
+   * equation i.
+   * @param n: The number of equations.
+   * @param m: The number of unknowns.
+   * @param b: A vector to represent the b of the linear equation.
+   * @param x: Used for store the solved unknown values, free unknowns are set
+   * to zero.
+   * @param where: Used for store the row index of coefficient for each solved
+   * value, -1 for a value which is not uniquely determined.
+   * @return 0 for no solution, 1 for exactly one solution, 2 for infinite
+   * number of solutions, kOverflow if an intermediate value overflowed.
+   */
+  static int Solve(const std::vector<long long> &A, int n, int m,
+                   const std::vector<long long> &b, std::vector<double> *x,
+                   std::vector<int> *where = nullptr) {
+    int width = m + 1;
+    std::vector<__int128> M(n * width);
     for (int i = 0; i < n; ++i) {
-      double sum = 0;
       for (int j = 0; j < m; ++j) {
-        sum += local_x[j] * local_A[i][j];
+        M[i * width + j] = A[i * m + j];
       }
+      M[i * width + m] = b[i];
+    }
 
-      if (std::fabs(sum - local_b[i]) > epsilon) {
+    std::vector<int> pivot_cols;
+    __int128 previous = 1;
+    int row = 0;
+    for (int col = 0; col < m && row < n; ++col) {
+      int pivot = -1;
+      for (int i = row; i < n; ++i) {
+        if (M[i * width + col] != 0) {
+          pivot = i;
+          break;
+        }
+      }
+
+      if (pivot == -1) {
+        continue;
+      }
+
+      std::swap_ranges(M.begin() + pivot * width,
+                       M.begin() + (pivot + 1) * width,
+                       M.begin() + row * width);
+
+      // Every other row becomes (p * row_i - a_i * row_pivot) / previous,
+      // where the division is exact by Sylvester's identity.
+      const __int128 *pivot_row = M.data() + row * width;
+      __int128 p = pivot_row[col];
+      for (int i = 0; i < n; ++i) {
+        if (i == row) {
+          continue;
+        }
+
+        __int128 *r = M.data() + i * width;
+        __int128 a = r[col];
+        for (int j = 0; j < width; ++j) {
+          __int128 left, right;
+          if (__builtin_mul_overflow(p, r[j], &left) ||
+              __builtin_mul_overflow(a, pivot_row[j], &right) ||
+              __builtin_sub_overflow(left, right, &left)) {
+            return kOverflow;
+          }
+          r[j] = left / previous;
+        }
+      }
+
+      previous = p;
+      pivot_cols.push_back(col);
+      ++row;
+    }
+
+    int rank = pivot_cols.size();
+    int solution_num = rank < m ? 2 : 1;
+    for (int i = rank; i < n; ++i) {
+      if (M[i * width + m] != 0) {
         solution_num = 0;
       }
     }
 
-    if (solution_num != 0) {
+    // All pivots now equal the last one, the determinant of the pivot minor.
+    std::vector<double> local_x(m, 0);
+    std::vector<int> local_where(m, -1);
+    for (int t = 0; t < rank; ++t) {
+      local_x[pivot_cols[t]] =
+          (double)M[t * width + m] / (double)M[t * width + pivot_cols[t]];
+      local_where[pivot_cols[t]] = t;
       for (int j = 0; j < m; ++j) {
-        if (local_where[j] == -1) {
-          solution_num = 2;
+        if (j != pivot_cols[t] && M[t * width + j] != 0) {
+          local_where[pivot_cols[t]] = -1;
         }
       }
     }
 
-    // After elimination, if an x is independent, its coefficient should not be
-    // zero and other coefficients in that row should all be zeros. So, in this
-    // step, I mark local_where as -1 for those non-independent x.
-    for (int j = 0; j < m; ++j) {
-      if (local_where[j] == -1) {
+    if (x != nullptr) {
+      *x = local_x;
+    }
+
+    if (where != nullptr) {
+      *where = local_where;
+    }
+
+    return solution_num;
+  }
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class ModularEquationSolver
+ * @brief Implements an equation solver over GF(p) based on Gaussian
+ * elimination and back substitution. Values are kept in Montgomery form, so
+ * every product is reduced by two multiplications and a shift instead of a
+ * division. For an integer system the classification over GF(p) equals the
+ * one over the rationals unless p divides one of the minors, which for a
+ * random 30-bit prime is very unlikely.
+ */
+class ModularEquationSolver {
+ public:
+  /**
+   * @brief Solves a linear algebraic equation like Ax = b modulo a prime.
+   * Time complexity: O(n*m*min(n,m)).
+   * @param A: The coefficients, A[i * m + j] is the coefficient of x_j in
+   * equation i, may be negative.
+   * @param n: The number of equations.
+   * @param m: The number of unknowns.
+   * @param b: A vector to represent the b of the linear equation.
+   * @param p: The prime modulus, assumed to be odd and below 2^30.
+   * @param x: Used for store the solved unknown values in 0 ~ p-1, free
+   * unknowns are set to zero.
+   * @param where: Used for store the row index of coefficient for each solved
+   * value, -1 for a value which is not uniquely determined.
+   * @return 0 for no solution, 1 for exactly one solution, 2 for p^k
+   * solutions.
+   */
+  static int Solve(const std::vector<long long> &A, int n, int m,
+                   const std::vector<long long> &b, uint32_t p,
+                   std::vector<uint32_t> *x,
+                   std::vector<int> *where = nullptr) {
+    Montgomery mont(p);
+    UpdateFunc update = SelectUpdate();
+
+    int width = m + 1;
+    std::vector<uint32_t> M(n * width);
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j < m; ++j) {
+        M[i * width + j] = mont.To(A[i * m + j]);
+      }
+      M[i * width + m] = mont.To(b[i]);
+    }
+
+    std::vector<int> pivot_cols;
+    int row = 0;
+    for (int col = 0; col < m && row < n; ++col) {
+      int pivot = -1;
+      for (int i = row; i < n; ++i) {
+        if (M[i * width + col] != 0) {
+          pivot = i;
+          break;
+        }
+      }
+
+      if (pivot == -1) {
         continue;
       }
 
-      int row = local_where[j];
+      std::swap_ranges(M.begin() + pivot * width,
+                       M.begin() + (pivot + 1) * width,
+                       M.begin() + row * width);
 
-      for (int k = 0; k < m; ++k) {
-        if (k == j) {
+      // Scale the pivot row so the pivot becomes one.
+      uint32_t *pivot_row = M.data() + row * width;
+      uint32_t inverse = mont.Inverse(pivot_row[col]);
+      for (int j = col; j < width; ++j) {
+        pivot_row[j] = mont.Multiply(pivot_row[j], inverse);
+      }
+
+      for (int i = row + 1; i < n; ++i) {
+        uint32_t *r = M.data() + i * width;
+        if (r[col] == 0) {
           continue;
         }
 
-        if (std::fabs(local_A[row][k]) > epsilon) {
-          local_where[j] = -1;
+        update(r, pivot_row, r[col], mont, col, width);
+      }
+
+      pivot_cols.push_back(col);
+      ++row;
+    }
+
+    int rank = pivot_cols.size();
+    int solution_num = rank < m ? 2 : 1;
+    for (int i = rank; i < n; ++i) {
+      if (M[i * width + m] != 0) {
+        solution_num = 0;
+      }
+    }
+
+    // Back substitution with the free unknowns set to zero.
+    std::vector<uint32_t> y(m, 0);
+    for (int t = rank - 1; t >= 0; --t) {
+      y[pivot_cols[t]] = BackSubstitute(M.data() + t * width, m, pivot_cols,
+                                        t, y, M[t * width + m], mont);
+    }
+
+    std::vector<uint32_t> local_x(m, 0);
+    std::vector<int> local_where(m, -1);
+    for (int t = 0; t < rank; ++t) {
+      local_x[pivot_cols[t]] = mont.From(y[pivot_cols[t]]);
+      local_where[pivot_cols[t]] = t;
+    }
+
+    // A solved value depends on the free unknown f exactly when the solution
+    // of U y = -column f (with x_f = 1) is non-zero at its pivot.
+    std::vector<bool> is_pivot(m, false);
+    for (int c : pivot_cols) {
+      is_pivot[c] = true;
+    }
+
+    for (int f = 0; f < m && rank > 0; ++f) {
+      if (is_pivot[f]) {
+        continue;
+      }
+
+      std::fill(y.begin(), y.end(), 0);
+      y[f] = mont.To(1);
+      for (int t = rank - 1; t >= 0; --t) {
+        y[pivot_cols[t]] =
+            BackSubstitute(M.data() + t * width, m, pivot_cols, t, y, 0, mont);
+        if (y[pivot_cols[t]] != 0) {
+          local_where[pivot_cols[t]] = -1;
         }
       }
     }
@@ -138,6 +1234,128 @@ class EquationSolver {
 
     return solution_num;
   }
+
+ private:
+  // Arithmetic modulo an odd p < 2^30 in Montgomery form, x * 2^32 mod p.
+  struct Montgomery {
+    explicit Montgomery(uint32_t p) : mod(p), negative_inverse(0), r2(0) {
+      uint32_t inverse = p;
+      for (int i = 0; i < 4; ++i) {
+        inverse *= 2 - p * inverse;
+      }
+      negative_inverse = -inverse;
+      uint64_t r = (1ULL << 32) % p;
+      r2 = r * r % p;
+    }
+
+    uint32_t Reduce(uint64_t t) const {
+      uint32_t q = (uint32_t)t * negative_inverse;
+      uint32_t u = (t + (uint64_t)q * mod) >> 32;
+      return u >= mod ? u - mod : u;
+    }
+
+    uint32_t Multiply(uint32_t a, uint32_t b) const {
+      return Reduce((uint64_t)a * b);
+    }
+
+    uint32_t To(long long value) const {
+      long long residue = value % (long long)mod;
+      if (residue < 0) {
+        residue += mod;
+      }
+      return Multiply(residue, r2);
+    }
+
+    uint32_t From(uint32_t a) const { return Reduce(a); }
+
+    uint32_t Inverse(uint32_t a) const {
+      // a^(p-2) by Fermat, starting from one in Montgomery form.
+      uint32_t result = To(1);
+      for (uint32_t e = mod - 2; e > 0; e >>= 1) {
+        if (e & 1) {
+          result = Multiply(result, a);
+        }
+        a = Multiply(a, a);
+      }
+      return result;
+    }
+
+    uint32_t mod;
+    uint32_t negative_inverse;
+    uint32_t r2;
+  };
+
+  /**
+   * @brief Computes rhs - sum(row[c] * y[c]) over the pivot columns after t
+   * and the free columns, i.e. the value of the pivot unknown of row t.
+   */
+  static uint32_t BackSubstitute(const uint32_t *row, int m,
+                                 const std::vector<int> &pivot_cols, int t,
+                                 const std::vector<uint32_t> &y, uint32_t rhs,
+                                 const Montgomery &mont) {
+    uint32_t value = rhs;
+    for (int j = pivot_cols[t] + 1; j < m; ++j) {
+      if (y[j] == 0) {
+        continue;
+      }
+
+      uint32_t v = mont.Multiply(row[j], y[j]);
+      value = value >= v ? value - v : value + mont.mod - v;
+    }
+    return value;
+  }
+
+  // Computes r[j] -= u[j] * ratio for j in begin ~ end-1.
+  using UpdateFunc = void (*)(uint32_t *r, const uint32_t *u, uint32_t ratio,
+                              const Montgomery &mont, int begin, int end);
+
+  static void UpdateScalar(uint32_t *r, const uint32_t *u, uint32_t ratio,
+                           const Montgomery &mont, int begin, int end) {
+    for (int j = begin; j < end; ++j) {
+      uint32_t v = mont.Multiply(u[j], ratio);
+      r[j] = r[j] >= v ? r[j] - v : r[j] + mont.mod - v;
+    }
+  }
+
+#ifdef AAPS_SOLVER_X86
+  // Eight Montgomery products at a time, the even and odd lanes are reduced
+  // separately as 64-bit products and merged from their high halves.
+  __attribute__((target("avx2"))) static void UpdateAvx2(
+      uint32_t *r, const uint32_t *u, uint32_t ratio, const Montgomery &mont,
+      int begin, int end) {
+    const __m256i mod = _mm256_set1_epi32(mont.mod);
+    const __m256i negative_inverse = _mm256_set1_epi32(mont.negative_inverse);
+    const __m256i factor = _mm256_set1_epi32(ratio);
+    int j = begin;
+    for (; j + 8 <= end; j += 8) {
+      __m256i a = _mm256_loadu_si256((const __m256i *)(u + j));
+      __m256i even = _mm256_mul_epu32(a, factor);
+      __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), factor);
+      even = _mm256_add_epi64(
+          even,
+          _mm256_mul_epu32(_mm256_mul_epu32(even, negative_inverse), mod));
+      odd = _mm256_add_epi64(
+          odd, _mm256_mul_epu32(_mm256_mul_epu32(odd, negative_inverse), mod));
+      __m256i v = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+      v = _mm256_min_epu32(v, _mm256_sub_epi32(v, mod));
+
+      __m256i d = _mm256_sub_epi32(
+          _mm256_loadu_si256((const __m256i *)(r + j)), v);
+      d = _mm256_min_epu32(d, _mm256_add_epi32(d, mod));
+      _mm256_storeu_si256((__m256i *)(r + j), d);
+    }
+    UpdateScalar(r, u, ratio, mont, j, end);
+  }
+#endif
+
+  static UpdateFunc SelectUpdate() {
+#ifdef AAPS_SOLVER_X86
+    if (__builtin_cpu_supports("avx2")) {
+      return UpdateAvx2;
+    }
+#endif
+    return UpdateScalar;
+  }
 };
 
 }  // namespace zhoni04
@@ -148,13 +1366,19 @@ using namespace aaps::zhoni04;
 int main(void) {
   int n;
   while (std::cin >> n && (n != 0)) {
-    std::vector<std::vector<double>> A(n);
+    // Only non-zeros are stored while reading, so a sparse system never
+    // takes n^2 memory.
+    CsrMatrix A(n, n);
     std::vector<double> b(n);
     for (int i = 0; i < n; ++i) {
-      A[i].resize(n);
       for (int j = 0; j < n; ++j) {
-        std::cin >> A[i][j];
+        double value;
+        std::cin >> value;
+        if (value != 0) {
+          A.Add(j, value);
+        }
       }
+      A.EndRow();
     }
 
     for (int i = 0; i < n; ++i) {
@@ -162,7 +1386,9 @@ int main(void) {
     }
 
     std::vector<double> x(n);
-    int result = EquationSolver::Solve(A, b, &x);
+    int result = SparseEquationSolver::Suits(A)
+                     ? SparseEquationSolver::Solve(A, b, &x)
+                     : EquationSolver::Solve(A.ToDense(), n, n, b, &x);
     if (result == 0) {
       std::cout << "inconsistent" << std::endl;
     } else if (result == 1) {
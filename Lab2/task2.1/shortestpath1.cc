@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -33,38 +34,427 @@ struct Edge {
 using GraphType = std::vector<std::vector<Edge>>;
 using ResultType = std::pair<std::vector<int>, std::vector<int>>;
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class CsrGraph
+ * @brief Implements a directed graph in compressed sparse row form. The edges
+ * of node u are begin(u) ~ end(u)-1, packed in one array of targets and one
+ * of payloads (weights), so there is no per-node allocation and no stored
+ * 'from'. Offsets are IndexType, which is not widened automatically: the
+ * default uint32_t is enough below 2^31 edges, and the caller must choose a
+ * 64-bit IndexType for more.
+ */
+template <typename EdgePayload, typename IndexType = uint32_t>
+class CsrGraph {
+ public:
+  /**
+   * @brief Builds the graph from an edge list in two counting passes, one for
+   * the offsets and one to place the edges. Edges of a node keep their order
+   * in the list. Time complexity: O(V + E).
+   * @param n: The number of nodes.
+   * @param from: The 'from' node of each edge.
+   * @param to: The 'to' node of each edge.
+   * @param payload: The payload of each edge, may be empty if not needed.
+   */
+  CsrGraph(int n, const std::vector<int>& from, const std::vector<int>& to,
+           const std::vector<EdgePayload>& payload = {})
+      : offsets_(n + 1, 0), targets_(to.size()), payloads_(payload.size()) {
+    for (int u : from) {
+      ++offsets_[u + 1];
+    }
+    for (int u = 0; u < n; ++u) {
+      offsets_[u + 1] += offsets_[u];
+    }
+
+    // Place each edge at the cursor of its node, which leaves offsets_[u]
+    // at the old offsets_[u + 1], then shift them back.
+    for (size_t e = 0; e < from.size(); ++e) {
+      IndexType at = offsets_[from[e]]++;
+      targets_[at] = to[e];
+      if (!payload.empty()) {
+        payloads_[at] = payload[e];
+      }
+    }
+    for (int u = n; u > 0; --u) {
+      offsets_[u] = offsets_[u - 1];
+    }
+    offsets_[0] = 0;
+  }
+
+  int size() const { return offsets_.size() - 1; }
+  IndexType edge_count() const { return targets_.size(); }
+  IndexType begin(int u) const { return offsets_[u]; }
+  IndexType end(int u) const { return offsets_[u + 1]; }
+  int target(IndexType e) const { return targets_[e]; }
+  const EdgePayload& payload(IndexType e) const { return payloads_[e]; }
+
+ private:
+  std::vector<IndexType> offsets_;
+  std::vector<int> targets_;
+  std::vector<EdgePayload> payloads_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Calls func(to, weight) for each edge of node u, so the algorithms
+ * below run on both graph forms.
+ * @param graph: The graph.
+ * @param u: The node.
+ * @param func: The function to call.
+ */
+template <typename Func>
+void ForEachEdge(const GraphType& graph, int u, const Func& func) {
+  for (auto& e : graph[u]) {
+    func(e.to, e.weight);
+  }
+}
+
+template <typename EdgePayload, typename IndexType, typename Func>
+void ForEachEdge(const CsrGraph<EdgePayload, IndexType>& graph, int u,
+                 const Func& func) {
+  for (IndexType e = graph.begin(u); e < graph.end(u); ++e) {
+    func(graph.target(e), graph.payload(e));
+  }
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class BinaryHeapQueue
+ * @brief Implements the priority queue of Dijkstras algorithm by a binary
+ * min-heap of (distance, node) pairs. Each queue below pops the same pairs in
+ * the same order: the least distance, and among equal distances the least
+ * node, so the parents found do not depend on the queue.
+ */
+class BinaryHeapQueue {
+ public:
+  void Push(int distance, int node) { heap_.push({distance, node}); }
+
+  std::pair<int, int> Pop() {
+    auto p = heap_.top();
+    heap_.pop();
+    return p;
+  }
+
+  bool Empty() const { return heap_.empty(); }
+
+ private:
+  using DistanceNodePair = std::pair<int, int>;
+  std::priority_queue<DistanceNodePair, std::vector<DistanceNodePair>,
+                      std::greater<DistanceNodePair>>
+      heap_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class RadixHeapQueue
+ * @brief Implements a monotone priority queue for non-negative integer keys,
+ * assuming no key below the last popped one is pushed, as in Dijkstras
+ * algorithm. Bucket i > 0 holds keys whose highest bit differing from the
+ * last popped key is bit i-1, bucket 0 the keys equal to it. When bucket 0
+ * runs out, the first non-empty bucket is spread over the lower ones, and
+ * each key moves down at most 32 times. Bucket 0 is a min-heap of nodes.
+ * Time complexity: O(log(C)) amortized per pop, C is the largest key.
+ */
+class RadixHeapQueue {
+ public:
+  RadixHeapQueue() : last_(0), size_(0) {}
+
+  void Push(int distance, int node) {
+    ++size_;
+    int bucket = Bucket(distance);
+    if (bucket == 0) {
+      PushEqual(node);
+    } else {
+      buckets_[bucket].push_back({distance, node});
+    }
+  }
+
+  std::pair<int, int> Pop() {
+    if (equal_.empty()) {
+      int i = 1;
+      while (buckets_[i].empty()) {
+        ++i;
+      }
+
+      last_ = buckets_[i][0].first;
+      for (auto& p : buckets_[i]) {
+        last_ = std::min(last_, p.first);
+      }
+      for (auto& p : buckets_[i]) {
+        int bucket = Bucket(p.first);
+        if (bucket == 0) {
+          PushEqual(p.second);
+        } else {
+          buckets_[bucket].push_back(p);
+        }
+      }
+      buckets_[i].clear();
+    }
+
+    std::pop_heap(equal_.begin(), equal_.end(), std::greater<int>());
+    int node = equal_.back();
+    equal_.pop_back();
+    --size_;
+    return {last_, node};
+  }
+
+  bool Empty() const { return size_ == 0; }
+
+ private:
+  int Bucket(int key) const {
+    uint32_t diff = (uint32_t)key ^ (uint32_t)last_;
+    return diff == 0 ? 0 : 32 - __builtin_clz(diff);
+  }
+
+  void PushEqual(int node) {
+    equal_.push_back(node);
+    std::push_heap(equal_.begin(), equal_.end(), std::greater<int>());
+  }
+
+  int last_;
+  int size_;
+  std::vector<int> equal_;
+  std::vector<std::pair<int, int>> buckets_[33];
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class DialQueue
+ * @brief Implements Dials bucket queue for Dijkstras algorithm with edge
+ * weights at most max_weight: every queued distance lies within max_weight of
+ * the last popped one, so max_weight + 1 buckets indexed by distance modulo
+ * that number never mix two distances. Each bucket is a min-heap of nodes.
+ * Time complexity: O(1) per push and amortized O(max_weight / E) per pop
+ * apart from the heaps, which only matter with many equal distances.
+ */
+class DialQueue {
+ public:
+  explicit DialQueue(int max_weight)
+      : buckets_(max_weight + 1), current_(0), size_(0) {}
+
+  void Push(int distance, int node) {
+    std::vector<int>& bucket = buckets_[distance % buckets_.size()];
+    bucket.push_back(node);
+    std::push_heap(bucket.begin(), bucket.end(), std::greater<int>());
+    ++size_;
+  }
+
+  std::pair<int, int> Pop() {
+    while (buckets_[current_ % buckets_.size()].empty()) {
+      ++current_;
+    }
+
+    std::vector<int>& bucket = buckets_[current_ % buckets_.size()];
+    std::pop_heap(bucket.begin(), bucket.end(), std::greater<int>());
+    int node = bucket.back();
+    bucket.pop_back();
+    --size_;
+    return {current_, node};
+  }
+
+  bool Empty() const { return size_ == 0; }
+
+ private:
+  std::vector<std::vector<int>> buckets_;
+  int current_;
+  int size_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class IndexedHeap
+ * @brief Implements an indexed d-ary min-heap of (key, node) pairs over the
+ * nodes 0..n-1, holding each node at most once. Pushing a queued node
+ * decreases its key in place instead of adding a second entry, so the heap
+ * never grows beyond n and no stale entries are popped. Equal keys pop the
+ * least node first. Reset keeps the storage, so one heap can serve many
+ * searches. Time complexity: O(log(n)) per push and decrease, O(d*log(n)) per
+ * pop, with log taken base d.
+ */
+template <typename KeyType, int kArity = 4>
+class IndexedHeap {
+ public:
+  explicit IndexedHeap(int n = 0) : position_(n, kAbsent) {}
+
+  /**
+   * @brief Empties the heap and sizes it for the nodes 0..n-1.
+   * @param n: The number of nodes.
+   */
+  void Reset(int n) {
+    entries_.clear();
+    position_.assign(n, kAbsent);
+  }
+
+  /**
+   * @brief Inserts a node, or decreases its key if it is already queued.
+   * @param key: The key, not above the current key of a queued node.
+   * @param node: The node.
+   */
+  void Push(KeyType key, int node) {
+    if (position_[node] == kAbsent) {
+      entries_.push_back({key, node});
+      SiftUp(entries_.size() - 1);
+    } else {
+      DecreaseKey(key, node);
+    }
+  }
+
+  /**
+   * @brief Decreases the key of a queued node.
+   * @param key: The new key, not above the current one.
+   * @param node: The node.
+   */
+  void DecreaseKey(KeyType key, int node) {
+    int i = position_[node];
+    entries_[i].first = key;
+    SiftUp(i);
+  }
+
+  /**
+   * @brief Removes the pair with the least key.
+   * @return The pair.
+   */
+  std::pair<KeyType, int> Pop() {
+    Entry top = entries_[0];
+    position_[top.second] = kAbsent;
+
+    Entry last = entries_.back();
+    entries_.pop_back();
+    if (!entries_.empty()) {
+      SiftDown(0, last);
+    }
+
+    return top;
+  }
+
+  /**
+   * @brief Empties the heap in time proportional to its size, keeping the
+   * number of nodes.
+   */
+  void Clear() {
+    for (auto& entry : entries_) {
+      position_[entry.second] = kAbsent;
+    }
+    entries_.clear();
+  }
+
+  const std::pair<KeyType, int>& Top() const { return entries_[0]; }
+
+  bool Contains(int node) const { return position_[node] != kAbsent; }
+
+  bool Empty() const { return entries_.empty(); }
+
+  int size() const { return entries_.size(); }
+
+ private:
+  using Entry = std::pair<KeyType, int>;
+
+  static constexpr int kAbsent = -1;
+
+  void SiftUp(int i) {
+    Entry entry = entries_[i];
+    while (i > 0) {
+      int parent = (i - 1) / kArity;
+      if (!(entry < entries_[parent])) {
+        break;
+      }
+
+      Place(i, entries_[parent]);
+      i = parent;
+    }
+
+    Place(i, entry);
+  }
+
+  void SiftDown(int i, const Entry& entry) {
+    int n = entries_.size();
+    while (true) {
+      int first = i * kArity + 1;
+      if (first >= n) {
+        break;
+      }
+
+      int last = std::min(first + kArity, n);
+      int best = first;
+      for (int child = first + 1; child < last; ++child) {
+        if (entries_[child] < entries_[best]) {
+          best = child;
+        }
+      }
+
+      if (!(entries_[best] < entry)) {
+        break;
+      }
+
+      Place(i, entries_[best]);
+      i = best;
+    }
+
+    Place(i, entry);
+  }
+
+  void Place(int i, const Entry& entry) {
+    entries_[i] = entry;
+    position_[entry.second] = i;
+  }
+
+  std::vector<Entry> entries_;
+  std::vector<int> position_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Finds the largest edge weight of a graph, the bound DialQueue needs.
+ * Time complexity: O(V + E).
+ * @param graph: The graph.
+ * @return The largest weight, 0 for a graph without edges.
+ */
+template <typename Graph>
+int MaxWeight(const Graph& graph) {
+  int max_weight = 0;
+  for (int u = 0; u < (int)graph.size(); ++u) {
+    ForEachEdge(graph, u, [&](int to, int weight) {
+      max_weight = std::max(max_weight, weight);
+    });
+  }
+
+  return max_weight;
+}
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implement Dijkstras algorithm to find the shortest path from one
  * node to all other nodes in a graph with non-negative edge weights. The graph
- * is stored by an adjacency list, and I used a min-heap to store path of
- * undetermined nodes. So the time complexity is O(V + E*logV), where V is the
- * total number of vertex(nodes), and E is the total number of edges.
- * @param graph: The graph, which stores edges of each node.
+ * is stored by an adjacency list, and the undetermined nodes are kept in a
+ * priority queue given as a policy: IndexedHeap, BinaryHeapQueue,
+ * RadixHeapQueue or DialQueue. With the heaps the time complexity is
+ * O(V + E*logV), where V is the total number of vertex(nodes), and E is the
+ * total number of edges; the indexed heap holds at most V nodes where the
+ * binary heap holds up to E pairs. The radix heap takes O(E + V*log(C)) for
+ * largest distance C and the Dial queue O(E + V + C). The result is the same
+ * for every queue.
+ * @param graph: The graph, which stores edges of each node, a GraphType or a
+ * CsrGraph.
  * @param start: The start node.
+ * @param queue: The empty priority queue to use, an IndexedHeap Reset to the
+ * number of nodes. It is taken by reference, so a queue can be reused.
  * @return: A pair, the first is the distance vector and the second is the
  * parent vector.
  */
-ResultType ShortestPath(const GraphType& graph, int start) {
+template <typename Graph, typename Queue>
+ResultType ShortestPath(const Graph& graph, int start, Queue&& queue) {
   int n = graph.size();
 
   std::vector<int> distance(n, kInfinity);
   std::vector<int> parent(n, kInvalidNode);
   std::vector<bool> found(n, false);
 
-  using DistanceNodePair = std::pair<int, int>;
-  using MinHeap =
-      std::priority_queue<DistanceNodePair, std::vector<DistanceNodePair>,
-                          std::greater<DistanceNodePair>>;
-
-  MinHeap heap;
-  heap.push(std::make_pair(0, start));
+  queue.Push(0, start);
   distance[start] = 0;
   parent[start] = start;
 
-  while (!heap.empty()) {
-    auto p = heap.top();
-    heap.pop();
+  while (!queue.Empty()) {
+    auto p = queue.Pop();
 
     int d = p.first;
     int u = p.second;
@@ -75,19 +465,731 @@ ResultType ShortestPath(const GraphType& graph, int start) {
 
     found[u] = true;
 
-    for (auto& e : graph[u]) {
-      if (!found[e.to] && distance[e.to] > d + e.weight) {
-        distance[e.to] = d + e.weight;
-        parent[e.to] = u;
+    ForEachEdge(graph, u, [&](int to, int weight) {
+      if (!found[to] && distance[to] > d + weight) {
+        distance[to] = d + weight;
+        parent[to] = u;
 
-        heap.push(std::make_pair(distance[e.to], e.to));
+        queue.Push(distance[to], to);
       }
-    }
+    });
   }
 
   return std::make_pair(distance, parent);
 }
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Same as above with an IndexedHeap.
+ * @param graph: The graph.
+ * @param start: The start node.
+ * @return: A pair, the first is the distance vector and the second is the
+ * parent vector.
+ */
+template <typename Graph>
+ResultType ShortestPath(const Graph& graph, int start) {
+  return ShortestPath(graph, start, IndexedHeap<int>(graph.size()));
+}
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class ShortestPathQuery
+ * @brief Answers point-to-point shortest path queries with non-negative edge
+ * weights by bidirectional Dijkstra: a forward search from s and a backward
+ * search from t on the reversed graph, stopped as soon as the least keys of
+ * the two frontiers add up to the best s-t path met so far.
+ *
+ * With landmarks the searches become A* with ALT lower bounds. The distances
+ * from and to each landmark are computed once, and by the triangle inequality
+ * they bound d(v, t) from below by pi_t(v) and d(s, v) by pi_s(v). The forward
+ * search uses (pi_t(v) - pi_s(v)) / 2 as potential and the backward search its
+ * negation, which keeps both consistent and the stop test exact. Keys are
+ * doubled, so the halves stay integral. Each landmark is the node farthest
+ * from those chosen before, unreachable nodes first.
+ *
+ * The state of a query is stamped, so a query only touches the nodes it
+ * visits. Time complexity: O(L*(V + E*logV)) for L landmarks once, and per
+ * query O(L*E'*logV') for the V' nodes and E' edges visited.
+ *
+ * This is a library addition for point-to-point queries; main does not use
+ * it, since all queries of a test case share one source and a single
+ * Dijkstra from it answers them all.
+ */
+class ShortestPathQuery {
+ public:
+  ShortestPathQuery(int n, const std::vector<int>& from,
+                    const std::vector<int>& to, const std::vector<int>& weight,
+                    int landmarks = 0)
+      : graph_(n, from, to, weight),
+        reverse_(n, to, from, weight),
+        landmarks_(std::min(landmarks, n)),
+        from_landmark_((size_t)n * landmarks_),
+        to_landmark_((size_t)n * landmarks_),
+        potential_(n),
+        potential_stamp_(n, 0),
+        stamp_(0),
+        settled_(0) {
+    for (int side = 0; side < 2; ++side) {
+      distance_[side].resize(n);
+      parent_[side].resize(n);
+      stamp_of_[side].assign(n, 0);
+      heap_[side].Reset(n);
+    }
+
+    ChooseLandmarks();
+  }
+
+  /**
+   * @brief Finds the shortest path from s to t.
+   * @param s: The source node.
+   * @param t: The target node.
+   * @param path: If not null, for storing the nodes of a shortest path from s
+   * to t, empty if there is none.
+   * @return The distance, kInfinity if t cannot be reached.
+   */
+  int Distance(int s, int t, std::vector<int>* path = nullptr) {
+    ++stamp_;
+    settled_ = 0;
+    source_ = s;
+    target_ = t;
+    heap_[0].Clear();
+    heap_[1].Clear();
+
+    Label(0, s, 0, s);
+    Label(1, t, 0, t);
+
+    long long best = kInfinity;
+    int meet = kInvalidNode;
+    if (s == t) {
+      best = 0;
+      meet = s;
+    }
+
+    while (!heap_[0].Empty() && !heap_[1].Empty()) {
+      long long forward = heap_[0].Top().first;
+      long long backward = heap_[1].Top().first;
+      if (forward + backward >= 2 * best) {
+        break;
+      }
+
+      int side = forward <= backward ? 0 : 1;
+      int u = heap_[side].Pop().second;
+      ++settled_;
+
+      if (side == 0) {
+        Scan(0, graph_, u, &best, &meet);
+      } else {
+        Scan(1, reverse_, u, &best, &meet);
+      }
+    }
+
+    if (path != nullptr) {
+      path->clear();
+      if (meet != kInvalidNode) {
+        for (int v = meet; v != s; v = parent_[0][v]) {
+          path->push_back(v);
+        }
+        path->push_back(s);
+        std::reverse(path->begin(), path->end());
+
+        for (int v = meet; v != t;) {
+          v = parent_[1][v];
+          path->push_back(v);
+        }
+      }
+    }
+
+    return best;
+  }
+
+  int landmarks() const { return landmarks_; }
+
+  /**
+   * @brief Gets the number of nodes settled by the last query, by both
+   * searches together.
+   */
+  int settled() const { return settled_; }
+
+ private:
+  void ChooseLandmarks() {
+    int n = graph_.size();
+    if (landmarks_ == 0) {
+      return;
+    }
+
+    IndexedHeap<int> heap(n);
+    std::vector<int> nearest = ShortestPath(graph_, 0, heap).first;
+
+    for (int i = 0; i < landmarks_; ++i) {
+      int landmark =
+          std::max_element(nearest.begin(), nearest.end()) - nearest.begin();
+
+      heap.Reset(n);
+      std::vector<int> from = ShortestPath(graph_, landmark, heap).first;
+      heap.Reset(n);
+      std::vector<int> to = ShortestPath(reverse_, landmark, heap).first;
+
+      for (int v = 0; v < n; ++v) {
+        from_landmark_[(size_t)v * landmarks_ + i] = from[v];
+        to_landmark_[(size_t)v * landmarks_ + i] = to[v];
+        nearest[v] = std::min(nearest[v], from[v]);
+      }
+    }
+  }
+
+  /**
+   * @brief Gets twice the potential of the forward search at node v,
+   * pi_t(v) - pi_s(v), 0 without landmarks. Bounds through a landmark that
+   * does not reach or is not reached are left out.
+   */
+  long long Potential(int v) {
+    if (potential_stamp_[v] == stamp_) {
+      return potential_[v];
+    }
+
+    const int* from_v = from_landmark_.data() + (size_t)v * landmarks_;
+    const int* to_v = to_landmark_.data() + (size_t)v * landmarks_;
+    const int* from_s = from_landmark_.data() + (size_t)source_ * landmarks_;
+    const int* to_s = to_landmark_.data() + (size_t)source_ * landmarks_;
+    const int* from_t = from_landmark_.data() + (size_t)target_ * landmarks_;
+    const int* to_t = to_landmark_.data() + (size_t)target_ * landmarks_;
+
+    int to_target = 0;
+    int from_source = 0;
+    for (int i = 0; i < landmarks_; ++i) {
+      if (from_v[i] != kInfinity) {
+        if (from_t[i] != kInfinity) {
+          to_target = std::max(to_target, from_t[i] - from_v[i]);
+        }
+        if (from_s[i] != kInfinity) {
+          from_source = std::max(from_source, from_v[i] - from_s[i]);
+        }
+      }
+      if (to_v[i] != kInfinity) {
+        if (to_t[i] != kInfinity) {
+          to_target = std::max(to_target, to_v[i] - to_t[i]);
+        }
+        if (to_s[i] != kInfinity) {
+          from_source = std::max(from_source, to_s[i] - to_v[i]);
+        }
+      }
+    }
+
+    potential_stamp_[v] = stamp_;
+    potential_[v] = (long long)to_target - from_source;
+    return potential_[v];
+  }
+
+  void Label(int side, int v, int d, int parent) {
+    stamp_of_[side][v] = stamp_;
+    distance_[side][v] = d;
+    parent_[side][v] = parent;
+
+    long long potential = Potential(v);
+    heap_[side].Push(2LL * d + (side == 0 ? potential : -potential), v);
+  }
+
+  template <typename Graph>
+  void Scan(int side, const Graph& graph, int u, long long* best,
+            int* meet) {
+    int d = distance_[side][u];
+
+    ForEachEdge(graph, u, [&](int v, int weight) {
+      bool reached = stamp_of_[side][v] == stamp_;
+      if (reached && !heap_[side].Contains(v)) {
+        return;
+      }
+
+      int distance = d + weight;
+      if (!reached || distance < distance_[side][v]) {
+        Label(side, v, distance, u);
+      }
+
+      if (stamp_of_[1 - side][v] == stamp_ &&
+          distance + distance_[1 - side][v] < *best) {
+        *best = distance + distance_[1 - side][v];
+        *meet = v;
+      }
+    });
+  }
+
+  CsrGraph<int> graph_;
+  CsrGraph<int> reverse_;
+  int landmarks_;
+  std::vector<int> from_landmark_;
+  std::vector<int> to_landmark_;
+  std::vector<long long> potential_;
+  std::vector<unsigned> potential_stamp_;
+  std::vector<int> distance_[2];
+  std::vector<int> parent_[2];
+  std::vector<unsigned> stamp_of_[2];
+  IndexedHeap<long long> heap_[2];
+  unsigned stamp_;
+  int settled_;
+  int source_;
+  int target_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class ContractionHierarchy
+ * @brief Answers repeated point-to-point shortest path queries on a static
+ * graph with non-negative edge weights by a contraction hierarchy.
+ *
+ * The nodes are contracted one by one, least priority first. The priority is
+ * the edge difference, shortcuts added minus edges removed, plus the number
+ * of contracted neighbors and the level, one above the highest contracted
+ * neighbor, which keeps the contraction spread evenly over the graph. When a
+ * node is contracted only those two terms of its neighbors are updated; the
+ * edge difference, which needs witness searches, is computed again when a
+ * node reaches the front, and the node goes back if it is no longer least.
+ *
+ * Contracting v adds a shortcut u->w of weight w(u, v) + w(v, w) unless a
+ * witness search from u avoiding v finds a path to w that is no longer. The
+ * witness search stops after kMaxSettled nodes, which can only add needless
+ * shortcuts, and after kMaxSettledEstimate when it only estimates a priority.
+ * A shortcut keeps the node it bypasses, so a path can be unpacked.
+ *
+ * Every edge then leads from a lower to a higher ranked node and is kept in
+ * the upward CSR graph if it leaves the lower end, else reversed in the
+ * downward one. A query searches upward from s and, on the downward graph,
+ * upward from t; a side stops once its least key reaches the best path met,
+ * and a node reached more cheaply from above is stalled, not scanned.
+ * Time complexity: the preprocessing depends on the graph, a query settles
+ * only the few nodes ranked above s and t.
+ *
+ * Like ShortestPathQuery this is a library addition that main does not use;
+ * it pays off only when many queries with different sources share a graph.
+ */
+class ContractionHierarchy {
+ public:
+  ContractionHierarchy(int n, const std::vector<int>& from,
+                       const std::vector<int>& to,
+                       const std::vector<int>& weight)
+      : up_(0, {}, {}),
+        down_(0, {}, {}),
+        rank_(n),
+        shortcuts_(0),
+        witness_heap_(n),
+        witness_distance_(n),
+        witness_stamp_(n, 0),
+        witness_round_(0),
+        target_stamp_(n, 0),
+        target_round_(0),
+        stamp_(0),
+        settled_(0) {
+    Contract(n, from, to, weight);
+
+    for (int side = 0; side < 2; ++side) {
+      distance_[side].resize(n);
+      parent_[side].resize(n);
+      middle_[side].resize(n);
+      stamp_of_[side].assign(n, 0);
+      heap_[side].Reset(n);
+    }
+  }
+
+  /**
+   * @brief Finds the shortest path from s to t.
+   * @param s: The source node.
+   * @param t: The target node.
+   * @param path: If not null, for storing the nodes of a shortest path from s
+   * to t with the shortcuts unpacked, empty if there is none.
+   * @return The distance, kInfinity if t cannot be reached.
+   */
+  int Distance(int s, int t, std::vector<int>* path = nullptr) {
+    ++stamp_;
+    settled_ = 0;
+    heap_[0].Clear();
+    heap_[1].Clear();
+
+    Label(0, s, 0, s, kInvalidNode);
+    Label(1, t, 0, t, kInvalidNode);
+
+    int best = kInfinity;
+    int meet = kInvalidNode;
+
+    while (true) {
+      bool forward = !heap_[0].Empty() && heap_[0].Top().first < best;
+      bool backward = !heap_[1].Empty() && heap_[1].Top().first < best;
+      if (!forward && !backward) {
+        break;
+      }
+
+      int side =
+          forward && (!backward || heap_[0].Top().first <= heap_[1].Top().first)
+              ? 0
+              : 1;
+      auto p = heap_[side].Pop();
+      int d = p.first;
+      int u = p.second;
+      ++settled_;
+
+      if (stamp_of_[1 - side][u] == stamp_ &&
+          d + distance_[1 - side][u] < best) {
+        best = d + distance_[1 - side][u];
+        meet = u;
+      }
+
+      if (Stalled(side, u, d)) {
+        continue;
+      }
+
+      const CsrGraph<HierarchyEdge>& graph = side == 0 ? up_ : down_;
+      for (uint32_t e = graph.begin(u); e < graph.end(u); ++e) {
+        int v = graph.target(e);
+        int distance = d + graph.payload(e).weight;
+        if (stamp_of_[side][v] != stamp_ || distance < distance_[side][v]) {
+          Label(side, v, distance, u, graph.payload(e).middle);
+        }
+      }
+    }
+
+    if (path != nullptr) {
+      path->clear();
+      if (meet != kInvalidNode) {
+        std::vector<int> chain;
+        for (int v = meet; v != s; v = parent_[0][v]) {
+          chain.push_back(v);
+        }
+
+        path->push_back(s);
+        for (int i = chain.size() - 1; i >= 0; --i) {
+          int v = chain[i];
+          Unpack(parent_[0][v], v, middle_[0][v], path);
+        }
+        for (int v = meet; v != t; v = parent_[1][v]) {
+          Unpack(v, parent_[1][v], middle_[1][v], path);
+        }
+      }
+    }
+
+    return best;
+  }
+
+  int size() const { return rank_.size(); }
+
+  /**
+   * @brief Gets the number of edges kept, the shortcuts included.
+   */
+  int edge_count() const { return up_.edge_count() + down_.edge_count(); }
+
+  int shortcuts() const { return shortcuts_; }
+
+  /**
+   * @brief Gets the number of nodes settled by the last query, by both
+   * searches together.
+   */
+  int settled() const { return settled_; }
+
+ private:
+  static constexpr int kMaxSettled = 64;
+  static constexpr int kMaxSettledEstimate = 16;
+
+  struct HierarchyEdge {
+    int weight;
+    int middle;
+  };
+
+  struct Arc {
+    int node;
+    int weight;
+    int middle;
+  };
+
+  struct PathEdge {
+    int tail;
+    int head;
+    int middle;
+  };
+
+  void Contract(int n, const std::vector<int>& from, const std::vector<int>& to,
+                const std::vector<int>& weight) {
+    out_.assign(n, {});
+    in_.assign(n, {});
+    for (size_t e = 0; e < from.size(); ++e) {
+      if (from[e] != to[e]) {
+        AddArc(from[e], to[e], weight[e], kInvalidNode);
+      }
+    }
+
+    deleted_.assign(n, 0);
+    level_.assign(n, 0);
+    priority_.resize(n);
+
+    using PriorityNodePair = std::pair<int, int>;
+    std::priority_queue<PriorityNodePair, std::vector<PriorityNodePair>,
+                        std::greater<PriorityNodePair>>
+        queue;
+    for (int v = 0; v < n; ++v) {
+      priority_[v] = Priority(v);
+      queue.push(std::make_pair(priority_[v], v));
+    }
+
+    std::vector<bool> contracted(n, false);
+    std::vector<int> up_from, up_to, down_from, down_to;
+    std::vector<HierarchyEdge> up_edges, down_edges;
+
+    for (int order = 0; order < n;) {
+      auto p = queue.top();
+      queue.pop();
+
+      int v = p.second;
+      if (contracted[v] || p.first != priority_[v]) {
+        continue;
+      }
+
+      priority_[v] = Priority(v);
+      if (!queue.empty() && priority_[v] > queue.top().first) {
+        queue.push(std::make_pair(priority_[v], v));
+        continue;
+      }
+
+      shortcuts_ += Shortcuts(v, true);
+      contracted[v] = true;
+      rank_[v] = order++;
+
+      for (auto& arc : out_[v]) {
+        up_from.push_back(v);
+        up_to.push_back(arc.node);
+        up_edges.push_back({arc.weight, arc.middle});
+        RemoveArc(&in_[arc.node], v);
+      }
+      for (auto& arc : in_[v]) {
+        down_from.push_back(v);
+        down_to.push_back(arc.node);
+        down_edges.push_back({arc.weight, arc.middle});
+        RemoveArc(&out_[arc.node], v);
+      }
+
+      for (auto* arcs : {&out_[v], &in_[v]}) {
+        for (auto& arc : *arcs) {
+          int x = arc.node;
+          int before = deleted_[x] + level_[x];
+          ++deleted_[x];
+          level_[x] = std::max(level_[x], level_[v] + 1);
+          priority_[x] += deleted_[x] + level_[x] - before;
+          queue.push(std::make_pair(priority_[x], x));
+        }
+      }
+
+      std::vector<Arc>().swap(out_[v]);
+      std::vector<Arc>().swap(in_[v]);
+    }
+
+    up_ = CsrGraph<HierarchyEdge>(n, up_from, up_to, up_edges);
+    down_ = CsrGraph<HierarchyEdge>(n, down_from, down_to, down_edges);
+
+    std::vector<std::vector<Arc>>().swap(out_);
+    std::vector<std::vector<Arc>>().swap(in_);
+    std::vector<int>().swap(deleted_);
+    std::vector<int>().swap(level_);
+    std::vector<int>().swap(priority_);
+    std::vector<int>().swap(witness_distance_);
+    std::vector<unsigned>().swap(witness_stamp_);
+    std::vector<unsigned>().swap(target_stamp_);
+    witness_heap_ = IndexedHeap<int>();
+  }
+
+  /**
+   * @brief Adds the arc u->w, or lowers the weight of an existing one, so
+   * there is at most one arc between two nodes in each direction.
+   */
+  void AddArc(int u, int w, int weight, int middle) {
+    for (auto& arc : out_[u]) {
+      if (arc.node == w) {
+        if (weight < arc.weight) {
+          arc.weight = weight;
+          arc.middle = middle;
+          for (auto& back : in_[w]) {
+            if (back.node == u) {
+              back.weight = weight;
+              back.middle = middle;
+            }
+          }
+        }
+        return;
+      }
+    }
+
+    out_[u].push_back({w, weight, middle});
+    in_[w].push_back({u, weight, middle});
+  }
+
+  static void RemoveArc(std::vector<Arc>* arcs, int node) {
+    for (size_t i = 0; i < arcs->size(); ++i) {
+      if ((*arcs)[i].node == node) {
+        (*arcs)[i] = arcs->back();
+        arcs->pop_back();
+        return;
+      }
+    }
+  }
+
+  int Priority(int v) {
+    return Shortcuts(v, false) - (int)in_[v].size() - (int)out_[v].size() +
+           deleted_[v] + level_[v];
+  }
+
+  /**
+   * @brief Counts, and if add is set inserts, the shortcuts needed to
+   * contract v.
+   */
+  int Shortcuts(int v, bool add) {
+    int max_out = 0;
+    ++target_round_;
+    for (auto& arc : out_[v]) {
+      max_out = std::max(max_out, arc.weight);
+      target_stamp_[arc.node] = target_round_;
+    }
+
+    int count = 0;
+    for (auto& in : in_[v]) {
+      int u = in.node;
+      WitnessSearch(u, v, in.weight + max_out, out_[v].size(),
+                    add ? kMaxSettled : kMaxSettledEstimate);
+
+      for (auto& out : out_[v]) {
+        int w = out.node;
+        int distance = in.weight + out.weight;
+        if (w == u || (witness_stamp_[w] == witness_round_ &&
+                       witness_distance_[w] <= distance)) {
+          continue;
+        }
+
+        ++count;
+        if (add) {
+          AddArc(u, w, distance, v);
+        }
+      }
+    }
+
+    return count;
+  }
+
+  /**
+   * @brief Runs Dijkstras algorithm from u on the remaining graph without v,
+   * until the keys pass limit, the targets of v are all settled, or
+   * max_settled nodes are. The distances found are in witness_distance_ where
+   * witness_stamp_ is witness_round_.
+   */
+  void WitnessSearch(int u, int v, int limit, int targets, int max_settled) {
+    ++witness_round_;
+    witness_heap_.Clear();
+
+    witness_stamp_[u] = witness_round_;
+    witness_distance_[u] = 0;
+    witness_heap_.Push(0, u);
+
+    for (int settled = 0; settled < max_settled && !witness_heap_.Empty();
+         ++settled) {
+      auto p = witness_heap_.Pop();
+      if (p.first > limit) {
+        break;
+      }
+      if (target_stamp_[p.second] == target_round_ && --targets == 0) {
+        break;
+      }
+
+      for (auto& arc : out_[p.second]) {
+        int w = arc.node;
+        int distance = p.first + arc.weight;
+        if (w != v && (witness_stamp_[w] != witness_round_ ||
+                       distance < witness_distance_[w])) {
+          witness_stamp_[w] = witness_round_;
+          witness_distance_[w] = distance;
+          witness_heap_.Push(distance, w);
+        }
+      }
+    }
+  }
+
+  void Label(int side, int v, int d, int parent, int middle) {
+    stamp_of_[side][v] = stamp_;
+    distance_[side][v] = d;
+    parent_[side][v] = parent;
+    middle_[side][v] = middle;
+    heap_[side].Push(d, v);
+  }
+
+  /**
+   * @brief Checks if u, settled at distance d by the given side, is reached
+   * more cheaply through a higher ranked node, in which case d is not its
+   * distance and its edges need not be scanned.
+   */
+  bool Stalled(int side, int u, int d) const {
+    const CsrGraph<HierarchyEdge>& graph = side == 0 ? down_ : up_;
+    for (uint32_t e = graph.begin(u); e < graph.end(u); ++e) {
+      int v = graph.target(e);
+      if (stamp_of_[side][v] == stamp_ &&
+          distance_[side][v] + graph.payload(e).weight < d) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * @brief Appends the nodes after u on the original path of the edge u->w,
+   * replacing each shortcut by the two edges through the node it bypasses.
+   * Those edges belong to that lower ranked node: u->middle is in its
+   * downward edges, middle->w in its upward ones.
+   */
+  void Unpack(int u, int w, int middle, std::vector<int>* path) const {
+    std::vector<PathEdge> stack = {{u, w, middle}};
+    while (!stack.empty()) {
+      PathEdge edge = stack.back();
+      stack.pop_back();
+
+      if (edge.middle == kInvalidNode) {
+        path->push_back(edge.head);
+        continue;
+      }
+
+      int m = edge.middle;
+      stack.push_back({m, edge.head, Middle(up_, m, edge.head)});
+      stack.push_back({edge.tail, m, Middle(down_, m, edge.tail)});
+    }
+  }
+
+  static int Middle(const CsrGraph<HierarchyEdge>& graph, int u, int v) {
+    for (uint32_t e = graph.begin(u); e < graph.end(u); ++e) {
+      if (graph.target(e) == v) {
+        return graph.payload(e).middle;
+      }
+    }
+
+    return kInvalidNode;
+  }
+
+  CsrGraph<HierarchyEdge> up_;
+  CsrGraph<HierarchyEdge> down_;
+  std::vector<int> rank_;
+  int shortcuts_;
+
+  // Only used while contracting.
+  std::vector<std::vector<Arc>> out_;
+  std::vector<std::vector<Arc>> in_;
+  std::vector<int> deleted_;
+  std::vector<int> level_;
+  std::vector<int> priority_;
+  IndexedHeap<int> witness_heap_;
+  std::vector<int> witness_distance_;
+  std::vector<unsigned> witness_stamp_;
+  unsigned witness_round_;
+  std::vector<unsigned> target_stamp_;
+  unsigned target_round_;
+
+  std::vector<int> distance_[2];
+  std::vector<int> parent_[2];
+  std::vector<int> middle_[2];
+  std::vector<unsigned> stamp_of_[2];
+  IndexedHeap<int> heap_[2];
+  unsigned stamp_;
+  int settled_;
+};
+
 }  // namespace zhoni04
 }  // namespace aaps
 
@@ -96,21 +1198,19 @@ using namespace aaps::zhoni04;
 
 int main(void) {
   int n, m, q, s;
-  Edge e;
 
   while (scanf("%d %d %d %d", &n, &m, &q, &s) != EOF) {
     if (n == 0 && m == 0 && q == 0 && s == 0) {
       break;
     }
 
-    GraphType graph(n);
-
+    std::vector<int> from(m), to(m), weight(m);
     for (int i = 0; i < m; ++i) {
-      scanf("%d %d %d", &e.from, &e.to, &e.weight);
-      graph[e.from].push_back(e);
+      scanf("%d %d %d", &from[i], &to[i], &weight[i]);
     }
+    CsrGraph<int> graph(n, from, to, weight);
 
-    auto result = ShortestPath(graph, s);
+    auto result = ShortestPath(graph, s, RadixHeapQueue());
     auto& distance = result.first;
 
     int qn;
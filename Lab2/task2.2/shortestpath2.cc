@@ -53,6 +53,135 @@ int GetWaitTime(int current_time, int t0, int P) {
   return t0 + t * P - current_time;
 }
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class IndexedHeap
+ * @brief Implements an indexed d-ary min-heap of (key, node) pairs over the
+ * nodes 0..n-1, holding each node at most once. Pushing a queued node
+ * decreases its key in place instead of adding a second entry, so the heap
+ * never grows beyond n and no stale entries are popped. Equal keys pop the
+ * least node first. Reset keeps the storage, so one heap can serve many
+ * searches. Time complexity: O(log(n)) per push and decrease, O(d*log(n)) per
+ * pop, with log taken base d.
+ */
+template <typename KeyType, int kArity = 4>
+class IndexedHeap {
+ public:
+  explicit IndexedHeap(int n = 0) : position_(n, kAbsent) {}
+
+  /**
+   * @brief Empties the heap and sizes it for the nodes 0..n-1.
+   * @param n: The number of nodes.
+   */
+  void Reset(int n) {
+    entries_.clear();
+    position_.assign(n, kAbsent);
+  }
+
+  /**
+   * @brief Inserts a node, or decreases its key if it is already queued.
+   * @param key: The key, not above the current key of a queued node.
+   * @param node: The node.
+   */
+  void Push(KeyType key, int node) {
+    if (position_[node] == kAbsent) {
+      entries_.push_back({key, node});
+      SiftUp(entries_.size() - 1);
+    } else {
+      DecreaseKey(key, node);
+    }
+  }
+
+  /**
+   * @brief Decreases the key of a queued node.
+   * @param key: The new key, not above the current one.
+   * @param node: The node.
+   */
+  void DecreaseKey(KeyType key, int node) {
+    int i = position_[node];
+    entries_[i].first = key;
+    SiftUp(i);
+  }
+
+  /**
+   * @brief Removes the pair with the least key.
+   * @return The pair.
+   */
+  std::pair<KeyType, int> Pop() {
+    Entry top = entries_[0];
+    position_[top.second] = kAbsent;
+
+    Entry last = entries_.back();
+    entries_.pop_back();
+    if (!entries_.empty()) {
+      SiftDown(0, last);
+    }
+
+    return top;
+  }
+
+  bool Contains(int node) const { return position_[node] != kAbsent; }
+
+  bool Empty() const { return entries_.empty(); }
+
+  int size() const { return entries_.size(); }
+
+ private:
+  using Entry = std::pair<KeyType, int>;
+
+  static constexpr int kAbsent = -1;
+
+  void SiftUp(int i) {
+    Entry entry = entries_[i];
+    while (i > 0) {
+      int parent = (i - 1) / kArity;
+      if (!(entry < entries_[parent])) {
+        break;
+      }
+
+      Place(i, entries_[parent]);
+      i = parent;
+    }
+
+    Place(i, entry);
+  }
+
+  void SiftDown(int i, const Entry& entry) {
+    int n = entries_.size();
+    while (true) {
+      int first = i * kArity + 1;
+      if (first >= n) {
+        break;
+      }
+
+      int last = std::min(first + kArity, n);
+      int best = first;
+      for (int child = first + 1; child < last; ++child) {
+        if (entries_[child] < entries_[best]) {
+          best = child;
+        }
+      }
+
+      if (!(entries_[best] < entry)) {
+        break;
+      }
+
+      Place(i, entries_[best]);
+      i = best;
+    }
+
+    Place(i, entry);
+  }
+
+  void Place(int i, const Entry& entry) {
+    entries_[i] = entry;
+    position_[entry.second] = i;
+  }
+
+  std::vector<Entry> entries_;
+  std::vector<int> position_;
+};
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implement Dijkstras algorithm to find the shortest path from one
@@ -61,37 +190,30 @@ int GetWaitTime(int current_time, int t0, int P) {
  * and E is the total number of edges.
  * @param graph: The graph, which stores edges of each node.
  * @param start: The start node.
+ * @param heap: The heap of undetermined nodes, reset here and reusable by the
+ * next call.
  * @return: A pair, the first is the distance vector and the second is the
  * parent vector.
  */
-ResultType ShortestPath(const GraphType& graph, int start) {
+ResultType ShortestPath(const GraphType& graph, int start,
+                        IndexedHeap<int>* heap) {
   int n = graph.size();
 
   std::vector<int> distance(n, kInfinity);
   std::vector<int> parent(n, kInvalidNode);
   std::vector<bool> found(n, false);
 
-  using DistanceNodePair = std::pair<int, int>;
-  using MinHeap =
-      std::priority_queue<DistanceNodePair, std::vector<DistanceNodePair>,
-                          std::greater<DistanceNodePair>>;
-
-  MinHeap heap;
-  heap.push(std::make_pair(0, start));
+  heap->Reset(n);
+  heap->Push(0, start);
   distance[start] = 0;
   parent[start] = start;
 
-  while (!heap.empty()) {
-    auto p = heap.top();
-    heap.pop();
+  while (!heap->Empty()) {
+    auto p = heap->Pop();
 
     int d = p.first;
     int u = p.second;
 
-    if (d > distance[u]) {
-      continue;
-    }
-
     found[u] = true;
 
     for (auto& e : graph[u]) {
@@ -106,7 +228,7 @@ ResultType ShortestPath(const GraphType& graph, int start) {
           distance[e.to] = d + weight;
           parent[e.to] = u;
 
-          heap.push(std::make_pair(distance[e.to], e.to));
+          heap->Push(distance[e.to], e.to);
         }
       }
     }
@@ -124,6 +246,7 @@ using namespace aaps::zhoni04;
 int main(void) {
   int n, m, q, s;
   Edge e;
+  IndexedHeap<int> heap;
 
   while (scanf("%d %d %d %d", &n, &m, &q, &s) != EOF) {
     if (n == 0 && m == 0 && q == 0 && s == 0) {
@@ -137,7 +260,7 @@ int main(void) {
       graph[e.from].push_back(e);
     }
 
-    auto result = ShortestPath(graph, s);
+    auto result = ShortestPath(graph, s, &heap);
     auto& distance = result.first;
 
     int qn;
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -33,6 +34,89 @@ struct Edge {
 using GraphType = std::vector<std::vector<Edge>>;
 using ResultType = std::pair<std::vector<int>, std::vector<int>>;
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class CsrGraph
+ * @brief Implements a directed graph in compressed sparse row form. The edges
+ * of node u are begin(u) ~ end(u)-1, packed in one array of targets and one
+ * of payloads (weights), so there is no per-node allocation and no stored
+ * 'from'. Offsets are IndexType, which is not widened automatically: the
+ * default uint32_t is enough below 2^31 edges, and the caller must choose a
+ * 64-bit IndexType for more.
+ */
+template <typename EdgePayload, typename IndexType = uint32_t>
+class CsrGraph {
+ public:
+  /**
+   * @brief Builds the graph from an edge list in two counting passes, one for
+   * the offsets and one to place the edges. Edges of a node keep their order
+   * in the list. Time complexity: O(V + E).
+   * @param n: The number of nodes.
+   * @param from: The 'from' node of each edge.
+   * @param to: The 'to' node of each edge.
+   * @param payload: The payload of each edge, may be empty if not needed.
+   */
+  CsrGraph(int n, const std::vector<int>& from, const std::vector<int>& to,
+           const std::vector<EdgePayload>& payload = {})
+      : offsets_(n + 1, 0), targets_(to.size()), payloads_(payload.size()) {
+    for (int u : from) {
+      ++offsets_[u + 1];
+    }
+    for (int u = 0; u < n; ++u) {
+      offsets_[u + 1] += offsets_[u];
+    }
+
+    // Place each edge at the cursor of its node, which leaves offsets_[u]
+    // at the old offsets_[u + 1], then shift them back.
+    for (size_t e = 0; e < from.size(); ++e) {
+      IndexType at = offsets_[from[e]]++;
+      targets_[at] = to[e];
+      if (!payload.empty()) {
+        payloads_[at] = payload[e];
+      }
+    }
+    for (int u = n; u > 0; --u) {
+      offsets_[u] = offsets_[u - 1];
+    }
+    offsets_[0] = 0;
+  }
+
+  int size() const { return offsets_.size() - 1; }
+  IndexType edge_count() const { return targets_.size(); }
+  IndexType begin(int u) const { return offsets_[u]; }
+  IndexType end(int u) const { return offsets_[u + 1]; }
+  int target(IndexType e) const { return targets_[e]; }
+  const EdgePayload& payload(IndexType e) const { return payloads_[e]; }
+
+ private:
+  std::vector<IndexType> offsets_;
+  std::vector<int> targets_;
+  std::vector<EdgePayload> payloads_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Calls func(to, weight) for each edge of node u, so the algorithms
+ * below run on both graph forms.
+ * @param graph: The graph.
+ * @param u: The node.
+ * @param func: The function to call.
+ */
+template <typename Func>
+void ForEachEdge(const GraphType& graph, int u, const Func& func) {
+  for (auto& e : graph[u]) {
+    func(e.to, e.weight);
+  }
+}
+
+template <typename EdgePayload, typename IndexType, typename Func>
+void ForEachEdge(const CsrGraph<EdgePayload, IndexType>& graph, int u,
+                 const Func& func) {
+  for (IndexType e = graph.begin(u); e < graph.end(u); ++e) {
+    func(graph.target(e), graph.payload(e));
+  }
+}
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implement Bellman-Fords algorithm for finding the shortest path from a
@@ -40,12 +124,14 @@ using ResultType = std::pair<std::vector<int>, std::vector<int>>;
  * there may exist negative cycles, the main loop may iterate V (the number of
  * nodes) times. So, the time complexity is O(V*E), where V is the total number
  * of vertex(nodes), and E is the total number of edges.
- * @param graph: The graph, which stores edges of each node.
+ * @param graph: The graph, which stores edges of each node, a GraphType or a
+ * CsrGraph.
  * @param start: The start node.
  * @return: A pair, the first is the distance vector and the second is the
  * parent vector.
  */
-ResultType ShortestPath(const GraphType& graph, int start) {
+template <typename Graph>
+ResultType ShortestPath(const Graph& graph, int start) {
   int n = graph.size();
 
   std::vector<int> distance(n, kInfinity);
@@ -62,13 +148,13 @@ ResultType ShortestPath(const GraphType& graph, int start) {
         continue;
       }
 
-      for (auto& e : graph[u]) {
-        if (distance[e.to] > distance[u] + e.weight) {
-          distance[e.to] = distance[u] + e.weight;
-          parent[e.to] = u;
+      ForEachEdge(graph, u, [&](int to, int weight) {
+        if (distance[to] > distance[u] + weight) {
+          distance[to] = distance[u] + weight;
+          parent[to] = u;
           update = true;
         }
-      }
+      });
     }
 
     if (!update) {
@@ -85,12 +171,12 @@ ResultType ShortestPath(const GraphType& graph, int start) {
         continue;
       }
 
-      for (auto& e : graph[u]) {
-        if (is_in_negtive_cycle[u] || distance[e.to] > distance[u] + e.weight) {
-          is_in_negtive_cycle[e.to] = true;
-          distance[e.to] = -kInfinity;
+      ForEachEdge(graph, u, [&](int to, int weight) {
+        if (is_in_negtive_cycle[u] || distance[to] > distance[u] + weight) {
+          is_in_negtive_cycle[to] = true;
+          distance[to] = -kInfinity;
         }
-      }
+      });
     }
   }
 
@@ -105,19 +191,17 @@ using namespace aaps::zhoni04;
 
 int main(void) {
   int n, m, q, s;
-  Edge e;
 
   while (scanf("%d %d %d %d", &n, &m, &q, &s) != EOF) {
     if (n == 0 && m == 0 && q == 0 && s == 0) {
       break;
     }
 
-    GraphType graph(n);
-
+    std::vector<int> from(m), to(m), weight(m);
     for (int i = 0; i < m; ++i) {
-      scanf("%d %d %d", &e.from, &e.to, &e.weight);
-      graph[e.from].push_back(e);
+      scanf("%d %d %d", &from[i], &to[i], &weight[i]);
     }
+    CsrGraph<int> graph(n, from, to, weight);
 
     auto result = ShortestPath(graph, s);
     auto& distance = result.first;
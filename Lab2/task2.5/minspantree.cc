@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -131,23 +132,107 @@ struct Edge {
 using GraphType = std::vector<std::vector<Edge>>;
 using ResultType = std::pair<WeightType, std::vector<Edge>>;
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class CsrGraph
+ * @brief Implements a directed graph in compressed sparse row form. The edges
+ * of node u are begin(u) ~ end(u)-1, packed in one array of targets and one
+ * of payloads (weights), so there is no per-node allocation and no stored
+ * 'from'. Offsets are IndexType, which is not widened automatically: the
+ * default uint32_t is enough below 2^31 edges, and the caller must choose a
+ * 64-bit IndexType for more.
+ */
+template <typename EdgePayload, typename IndexType = uint32_t>
+class CsrGraph {
+ public:
+  /**
+   * @brief Builds the graph from an edge list in two counting passes, one for
+   * the offsets and one to place the edges. Edges of a node keep their order
+   * in the list. Time complexity: O(V + E).
+   * @param n: The number of nodes.
+   * @param from: The 'from' node of each edge.
+   * @param to: The 'to' node of each edge.
+   * @param payload: The payload of each edge, may be empty if not needed.
+   */
+  CsrGraph(int n, const std::vector<int>& from, const std::vector<int>& to,
+           const std::vector<EdgePayload>& payload = {})
+      : offsets_(n + 1, 0), targets_(to.size()), payloads_(payload.size()) {
+    for (int u : from) {
+      ++offsets_[u + 1];
+    }
+    for (int u = 0; u < n; ++u) {
+      offsets_[u + 1] += offsets_[u];
+    }
+
+    // Place each edge at the cursor of its node, which leaves offsets_[u]
+    // at the old offsets_[u + 1], then shift them back.
+    for (size_t e = 0; e < from.size(); ++e) {
+      IndexType at = offsets_[from[e]]++;
+      targets_[at] = to[e];
+      if (!payload.empty()) {
+        payloads_[at] = payload[e];
+      }
+    }
+    for (int u = n; u > 0; --u) {
+      offsets_[u] = offsets_[u - 1];
+    }
+    offsets_[0] = 0;
+  }
+
+  int size() const { return offsets_.size() - 1; }
+  IndexType edge_count() const { return targets_.size(); }
+  IndexType begin(int u) const { return offsets_[u]; }
+  IndexType end(int u) const { return offsets_[u + 1]; }
+  int target(IndexType e) const { return targets_[e]; }
+  const EdgePayload& payload(IndexType e) const { return payloads_[e]; }
+
+ private:
+  std::vector<IndexType> offsets_;
+  std::vector<int> targets_;
+  std::vector<EdgePayload> payloads_;
+};
+
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Calls func(to, weight) for each edge of node u, so the algorithms
+ * below run on both graph forms.
+ * @param graph: The graph.
+ * @param u: The node.
+ * @param func: The function to call.
+ */
+template <typename Func>
+void ForEachEdge(const GraphType& graph, int u, const Func& func) {
+  for (auto& e : graph[u]) {
+    func(e.to, e.weight);
+  }
+}
+
+template <typename EdgePayload, typename IndexType, typename Func>
+void ForEachEdge(const CsrGraph<EdgePayload, IndexType>& graph, int u,
+                 const Func& func) {
+  for (IndexType e = graph.begin(u); e < graph.end(u); ++e) {
+    func(graph.target(e), graph.payload(e));
+  }
+}
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implements an algorithm for finding a minimum spanning tree. Time
  * complexity: O((|E|+|V|)·log(|V|)), where |E| is count of edges and |V| is
  * count of vertices.
- * @param edges: The total edges of the original graph.
+ * @param graph: The graph, a GraphType or a CsrGraph of weights.
  * @return: A pair. The first is the cost of mst, which sum of weight of mst
  * edges. The second is the edges. If there is no minimum spanning tree, the
  * cost is -kInfinity.
  */
-ResultType Mst(const GraphType& graph) {
+template <typename Graph>
+ResultType Mst(const Graph& graph) {
   std::vector<Edge> edges;
   int n = graph.size();
   for (int i = 0; i < n; ++i) {
-    for (auto& e : graph[i]) {
-      edges.push_back(e);
-    }
+    ForEachEdge(graph, i, [&](int to, WeightType weight) {
+      edges.push_back({i, to, weight});
+    });
   }
   std::sort(edges.begin(), edges.end());
 
@@ -190,21 +275,21 @@ int main(void) {
   int n, m;
   int u, v;
   WeightType w;
-  Edge e;
 
   while (scanf("%d %d", &n, &m) != EOF) {
     if (n == 0 && m == 0) {
       break;
     }
 
-    GraphType graph(n);
+    std::vector<int> from(m), to(m);
+    std::vector<WeightType> weight(m);
     for (int i = 0; i < m; ++i) {
       scanf("%d %d %lld", &u, &v, &w);
-      e.from = std::min(u, v);
-      e.to = std::max(u, v);
-      e.weight = w;
-      graph[e.from].push_back(e);
+      from[i] = std::min(u, v);
+      to[i] = std::max(u, v);
+      weight[i] = w;
     }
+    CsrGraph<WeightType> graph(n, from, to, weight);
 
     auto result = Mst(graph);
     auto& cost = result.first;
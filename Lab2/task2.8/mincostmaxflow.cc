@@ -47,6 +47,135 @@ struct Edge {
 using GraphType = std::vector<std::vector<Edge>>;
 using ResultType = std::pair<std::pair<WeightType, WeightType>, GraphType>;
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class IndexedHeap
+ * @brief Implements an indexed d-ary min-heap of (key, node) pairs over the
+ * nodes 0..n-1, holding each node at most once. Pushing a queued node
+ * decreases its key in place instead of adding a second entry, so the heap
+ * never grows beyond n and no stale entries are popped. Equal keys pop the
+ * least node first. Reset keeps the storage, so one heap can serve many
+ * searches. Time complexity: O(log(n)) per push and decrease, O(d*log(n)) per
+ * pop, with log taken base d.
+ */
+template <typename KeyType, int kArity = 4>
+class IndexedHeap {
+ public:
+  explicit IndexedHeap(int n = 0) : position_(n, kAbsent) {}
+
+  /**
+   * @brief Empties the heap and sizes it for the nodes 0..n-1.
+   * @param n: The number of nodes.
+   */
+  void Reset(int n) {
+    entries_.clear();
+    position_.assign(n, kAbsent);
+  }
+
+  /**
+   * @brief Inserts a node, or decreases its key if it is already queued.
+   * @param key: The key, not above the current key of a queued node.
+   * @param node: The node.
+   */
+  void Push(KeyType key, int node) {
+    if (position_[node] == kAbsent) {
+      entries_.push_back({key, node});
+      SiftUp(entries_.size() - 1);
+    } else {
+      DecreaseKey(key, node);
+    }
+  }
+
+  /**
+   * @brief Decreases the key of a queued node.
+   * @param key: The new key, not above the current one.
+   * @param node: The node.
+   */
+  void DecreaseKey(KeyType key, int node) {
+    int i = position_[node];
+    entries_[i].first = key;
+    SiftUp(i);
+  }
+
+  /**
+   * @brief Removes the pair with the least key.
+   * @return The pair.
+   */
+  std::pair<KeyType, int> Pop() {
+    Entry top = entries_[0];
+    position_[top.second] = kAbsent;
+
+    Entry last = entries_.back();
+    entries_.pop_back();
+    if (!entries_.empty()) {
+      SiftDown(0, last);
+    }
+
+    return top;
+  }
+
+  bool Contains(int node) const { return position_[node] != kAbsent; }
+
+  bool Empty() const { return entries_.empty(); }
+
+  int size() const { return entries_.size(); }
+
+ private:
+  using Entry = std::pair<KeyType, int>;
+
+  static constexpr int kAbsent = -1;
+
+  void SiftUp(int i) {
+    Entry entry = entries_[i];
+    while (i > 0) {
+      int parent = (i - 1) / kArity;
+      if (!(entry < entries_[parent])) {
+        break;
+      }
+
+      Place(i, entries_[parent]);
+      i = parent;
+    }
+
+    Place(i, entry);
+  }
+
+  void SiftDown(int i, const Entry& entry) {
+    int n = entries_.size();
+    while (true) {
+      int first = i * kArity + 1;
+      if (first >= n) {
+        break;
+      }
+
+      int last = std::min(first + kArity, n);
+      int best = first;
+      for (int child = first + 1; child < last; ++child) {
+        if (entries_[child] < entries_[best]) {
+          best = child;
+        }
+      }
+
+      if (!(entries_[best] < entry)) {
+        break;
+      }
+
+      Place(i, entries_[best]);
+      i = best;
+    }
+
+    Place(i, entry);
+  }
+
+  void Place(int i, const Entry& entry) {
+    entries_[i] = entry;
+    position_[entry.second] = i;
+  }
+
+  std::vector<Entry> entries_;
+  std::vector<int> position_;
+};
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Finds the shortest path from vertex s to vertex t by Dijkstras
@@ -57,41 +186,34 @@ using ResultType = std::pair<std::pair<WeightType, WeightType>, GraphType>;
  * @param t: The target (sink) vertex.
  * @param parent: For storing the edge between a vertex and its parent vertex.
  * @param potential: For storing the potential of each vertex.
+ * @param heap: The heap of undetermined vertices, reset here and reused by
+ * every augmentation.
  * @return: True if found a path, otherwise false.
  */
 bool ShortestPath(GraphType& graph, int s, int t, std::vector<Edge*>* parent,
-                  std::vector<WeightType>* potential) {
+                  std::vector<WeightType>* potential,
+                  IndexedHeap<WeightType>* heap) {
   int n = graph.size();
   parent->assign(n, nullptr);
 
   std::vector<WeightType> distance(n, kInfinity);
 
-  using DistanceNodePair = std::pair<WeightType, int>;
-  using MinHeap =
-      std::priority_queue<DistanceNodePair, std::vector<DistanceNodePair>,
-                          std::greater<DistanceNodePair>>;
-
-  MinHeap heap;
-  heap.push(std::make_pair(0, s));
+  heap->Reset(n);
+  heap->Push(0, s);
   distance[s] = 0;
 
-  while (!heap.empty()) {
-    auto p = heap.top();
-    heap.pop();
+  while (!heap->Empty()) {
+    auto p = heap->Pop();
 
     WeightType d = p.first;
     int u = p.second;
 
-    if (d > distance[u]) {
-      continue;
-    }
-
     for (auto& e : graph[u]) {
       if (e.flow < e.capacity &&
           distance[e.to] > d + e.cost + (*potential)[u] - (*potential)[e.to]) {
         distance[e.to] = d + e.cost + (*potential)[u] - (*potential)[e.to];
         (*parent)[e.to] = &e;
-        heap.push(std::make_pair(distance[e.to], e.to));
+        heap->Push(distance[e.to], e.to);
       }
     }
   }
@@ -125,12 +247,13 @@ ResultType MaxFlowMinCost(const GraphType& graph, int s, int t) {
   int n = graph.size();
   std::vector<Edge*> parent(n);
   std::vector<WeightType> potential(n, kInfinity);
+  IndexedHeap<WeightType> heap(n);
 
   WeightType max_flow = 0;
   WeightType min_cost = 0;
   GraphType flow_graph(graph);
 
-  while (ShortestPath(flow_graph, s, t, &parent, &potential)) {
+  while (ShortestPath(flow_graph, s, t, &parent, &potential, &heap)) {
     WeightType path_flow = kInfinity;
     for (auto e = parent[t]; e != nullptr; e = parent[e->from]) {
       path_flow = std::min(path_flow, e->capacity - e->flow);
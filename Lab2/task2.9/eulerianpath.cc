@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -26,18 +27,79 @@ namespace zhoni04 {
 using GraphType = std::vector<std::multiset<int>>;
 using ResultType = std::pair<bool, std::vector<int>>;
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @class CsrGraph
+ * @brief Implements a directed graph in compressed sparse row form. The edges
+ * of node u are begin(u) ~ end(u)-1, packed in one array of targets and one
+ * of payloads (weights), so there is no per-node allocation and no stored
+ * 'from'. Offsets are IndexType, which is not widened automatically: the
+ * default uint32_t is enough below 2^31 edges, and the caller must choose a
+ * 64-bit IndexType for more.
+ */
+template <typename EdgePayload, typename IndexType = uint32_t>
+class CsrGraph {
+ public:
+  /**
+   * @brief Builds the graph from an edge list in two counting passes, one for
+   * the offsets and one to place the edges. Edges of a node keep their order
+   * in the list. Time complexity: O(V + E).
+   * @param n: The number of nodes.
+   * @param from: The 'from' node of each edge.
+   * @param to: The 'to' node of each edge.
+   * @param payload: The payload of each edge, may be empty if not needed.
+   */
+  CsrGraph(int n, const std::vector<int>& from, const std::vector<int>& to,
+           const std::vector<EdgePayload>& payload = {})
+      : offsets_(n + 1, 0), targets_(to.size()), payloads_(payload.size()) {
+    for (int u : from) {
+      ++offsets_[u + 1];
+    }
+    for (int u = 0; u < n; ++u) {
+      offsets_[u + 1] += offsets_[u];
+    }
+
+    // Place each edge at the cursor of its node, which leaves offsets_[u]
+    // at the old offsets_[u + 1], then shift them back.
+    for (size_t e = 0; e < from.size(); ++e) {
+      IndexType at = offsets_[from[e]]++;
+      targets_[at] = to[e];
+      if (!payload.empty()) {
+        payloads_[at] = payload[e];
+      }
+    }
+    for (int u = n; u > 0; --u) {
+      offsets_[u] = offsets_[u - 1];
+    }
+    offsets_[0] = 0;
+  }
+
+  int size() const { return offsets_.size() - 1; }
+  IndexType edge_count() const { return targets_.size(); }
+  IndexType begin(int u) const { return offsets_[u]; }
+  IndexType end(int u) const { return offsets_[u + 1]; }
+  int target(IndexType e) const { return targets_[e]; }
+  const EdgePayload& payload(IndexType e) const { return payloads_[e]; }
+
+ private:
+  std::vector<IndexType> offsets_;
+  std::vector<int> targets_;
+  std::vector<EdgePayload> payloads_;
+};
+
 /**
  * @author Zhongjun Ni (LiU-ID: zhoni04)
  * @brief Implements an algorithm for finding an Euler path through a graph, if
- * one exists. The graph is stored by an adjacency list, and the time complexity
- * is O(E + V), where V is the total number of vertex(nodes), and E is the total
- * number of edges.
- * @param graph: The graph.
+ * one exists. Each node keeps a cursor to its next unused edge, so the graph
+ * is not modified. The time complexity is O(E + V), where V is the total
+ * number of vertex(nodes), and E is the total number of edges.
+ * @param graph: The graph, payloads are not used.
  * @return: A pair. The first is a bool value to indicate if found, true if
  * found, otherwise false. The second is the found path.
  */
-ResultType EulerianPath(GraphType* graph) {
-  int n = graph->size();
+template <typename EdgePayload, typename IndexType>
+ResultType EulerianPath(const CsrGraph<EdgePayload, IndexType>& graph) {
+  int n = graph.size();
   std::vector<int> in_degree(n, 0);
   std::vector<int> out_degree(n, 0);
 
@@ -46,15 +108,15 @@ ResultType EulerianPath(GraphType* graph) {
   int edges_num = 0;
   int start = 0;
   for (int i = 0; i < n; ++i) {
-    out_degree[i] = (*graph)[i].size();
+    out_degree[i] = graph.end(i) - graph.begin(i);
     if (out_degree[i] != 0) {
       start = i;
     }
 
     edges_num += out_degree[i];
 
-    for (auto& to : (*graph)[i]) {
-      ++in_degree[to];
+    for (IndexType e = graph.begin(i); e < graph.end(i); ++e) {
+      ++in_degree[graph.target(e)];
     }
   }
 
@@ -73,15 +135,18 @@ ResultType EulerianPath(GraphType* graph) {
 
   // Try to find path, in this loop, each edge will be visited at most once, so
   // the time complexity is O(E).
+  std::vector<IndexType> next_edge(n);
+  for (int i = 0; i < n; ++i) {
+    next_edge[i] = graph.begin(i);
+  }
+
   std::vector<int> path;
   std::stack<int> s;
   s.push(start);
   while (!s.empty()) {
     int curr = s.top();
-    if (!(*graph)[curr].empty()) {
-      auto itr = (*graph)[curr].begin();
-      s.push(*itr);
-      (*graph)[curr].erase(itr);
+    if (next_edge[curr] < graph.end(curr)) {
+      s.push(graph.target(next_edge[curr]++));
     } else {
       path.push_back(curr);
       s.pop();
@@ -104,6 +169,31 @@ ResultType EulerianPath(GraphType* graph) {
   return std::make_pair(find, path);
 }
 
+/**
+ * @author Zhongjun Ni (LiU-ID: zhoni04)
+ * @brief Implements an algorithm for finding an Euler path through a graph, if
+ * one exists. The multisets are packed into a CsrGraph, where each node's
+ * edges stay in increasing order of 'to', and the graph is emptied. The time
+ * complexity is O(E + V), where V is the total number of vertex(nodes), and E
+ * is the total number of edges.
+ * @param graph: The graph.
+ * @return: A pair. The first is a bool value to indicate if found, true if
+ * found, otherwise false. The second is the found path.
+ */
+ResultType EulerianPath(GraphType* graph) {
+  int n = graph->size();
+  std::vector<int> from, to;
+  for (int i = 0; i < n; ++i) {
+    for (int v : (*graph)[i]) {
+      from.push_back(i);
+      to.push_back(v);
+    }
+    (*graph)[i].clear();
+  }
+
+  return EulerianPath(CsrGraph<int>(n, from, to));
+}
+
 }  // namespace zhoni04
 }  // namespace aaps
 
@@ -118,15 +208,21 @@ int main(void) {
       break;
     }
 
-    GraphType graph(n);
+    // Sorted, so each node's edges are taken in increasing order of 'to', as
+    // in the multiset form.
+    std::vector<std::pair<int, int>> edges(m);
+    for (int i = 0; i < m; ++i) {
+      scanf("%d %d", &edges[i].first, &edges[i].second);
+    }
+    std::sort(edges.begin(), edges.end());
 
-    int u, v;
+    std::vector<int> from(m), to(m);
     for (int i = 0; i < m; ++i) {
-      scanf("%d %d", &u, &v);
-      graph[u].insert(v);
+      from[i] = edges[i].first;
+      to[i] = edges[i].second;
     }
 
-    auto result = EulerianPath(&graph);
+    auto result = EulerianPath(CsrGraph<int>(n, from, to));
     if (!result.first) {
       printf("Impossible\n");
     } else {